@@ -0,0 +1,68 @@
+// ============================================================
+// Microbenchmark del Lexer (src/lexer.h)
+// Tokenizza un sorgente .mmt generato (identificatori, keyword,
+// numeri, stringhe con e senza escape, commenti) e riporta il
+// tempo migliore e il throughput.
+// Uso: lexer_bench [MB]   (default 8 MB)
+// ============================================================
+#include "lexer.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+template<typename F>
+static double bestOf(int runs, F&& f) {
+    double best = 1e30;
+    for (int r = 0; r < runs; ++r) {
+        auto t0 = std::chrono::steady_clock::now();
+        f();
+        auto t1 = std::chrono::steady_clock::now();
+        double ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
+        if (ms < best) best = ms;
+    }
+    return best;
+}
+
+static volatile size_t sink;
+
+// Sorgente generato: funzioni, cicli e dichiarazioni con nomi distinti
+static std::string generate(size_t size) {
+    std::string src;
+    for (size_t i = 0; src.size() < size; ++i) {
+        std::string n = std::to_string(i);
+        src += "# blocco " + n + "\n";
+        src += "def calc_" + n + "(value_" + n + ": int, scale: double) -> double::\n";
+        src += "    double result = value_" + n + " * scale + 3.25\n";
+        src += "    if result > 100.0:: result = result - 42 end\n";
+        src += "    result\n";
+        src += "end\n";
+        src += "dynamic string names_" + n + "[] = \"alpha\", \"beta\", \"gamma\\n\"\n";
+        src += "for item in range(0, 10)::\n";
+        src += "    echo str(calc_" + n + "(item, 1.5)) $ \" -> \" $ names_" + n + "[item % 3]\n";
+        src += "end\n";
+    }
+    return src;
+}
+
+int main(int argc, char* argv[]) {
+    size_t mb = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 8;
+    std::string src = generate(mb * 1024 * 1024);
+
+    size_t count = 0;
+    double ms = bestOf(5, [&] {
+        Lexer lexer(src);
+        std::vector<Token> tokens = lexer.tokenize();
+        size_t bytes = 0;
+        for (const auto& t : tokens) bytes += t.lexeme.size();
+        count = tokens.size();
+        sink = bytes;
+    });
+
+    double mbs = (src.size() / (1024.0 * 1024.0)) / (ms / 1000.0);
+    std::printf("Lexer: %zu byte, %zu token, %8.3f ms, %7.1f MB/s\n",
+                src.size(), count, ms, mbs);
+    return 0;
+}
@@ -0,0 +1,86 @@
+// ============================================================
+// Microbenchmark dei kernel UTF-8 (src/utf8.h)
+// Confronta i kernel scelti a runtime (SSE2/AVX2) con la versione
+// scalare e la decodifica byte per byte precedente.
+// Uso: utf8_bench [MB]   (default 1 MB per testo)
+// ============================================================
+#include "utf8.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+// Decodifica scalare di riferimento: un codepoint alla volta
+static std::vector<char32_t> decodeScalar(const std::string& s) {
+    std::vector<char32_t> out;
+    const unsigned char* p   = reinterpret_cast<const unsigned char*>(s.data());
+    const unsigned char* end = p + s.size();
+    while (p < end) out.push_back(decodeUtf8Char(p, end));
+    return out;
+}
+
+template<typename F>
+static double bestOf(int runs, F&& f) {
+    double best = 1e30;
+    for (int r = 0; r < runs; ++r) {
+        auto t0 = std::chrono::steady_clock::now();
+        f();
+        auto t1 = std::chrono::steady_clock::now();
+        double ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
+        if (ms < best) best = ms;
+    }
+    return best;
+}
+
+static volatile size_t sink;
+
+static void run(const char* label, const std::string& text) {
+    const auto* p = reinterpret_cast<const unsigned char*>(text.data());
+    size_t n = text.size();
+    const auto scalar = utf8_kernels::scalarTable();
+    const auto& simd = utf8_kernels::active();
+    const int runs = 10;
+
+    std::printf("\n%s (%zu byte)\n", label, n);
+
+    double a = bestOf(runs, [&] { sink = decodeScalar(text).size(); });
+    double b = bestOf(runs, [&] { sink = decodeUtf8(text).size(); });
+    std::printf("  decodifica     scalare %8.3f ms   %-6s %8.3f ms\n", a, simd.name, b);
+
+    a = bestOf(runs, [&] { sink = scalar.countLeads(p, n); });
+    b = bestOf(runs, [&] { sink = simd.countLeads(p, n); });
+    std::printf("  conteggio      scalare %8.3f ms   %-6s %8.3f ms\n", a, simd.name, b);
+
+    a = bestOf(runs, [&] { sink = scalar.asciiPrefix(p, n); });
+    b = bestOf(runs, [&] { sink = simd.asciiPrefix(p, n); });
+    std::printf("  prefisso ASCII scalare %8.3f ms   %-6s %8.3f ms\n", a, simd.name, b);
+
+    b = bestOf(runs, [&] { sink = buildUtf8Index(text).length; });
+    std::printf("  indice (validazione + offset)         %8.3f ms\n", b);
+
+    Utf8Index idx = buildUtf8Index(text);
+    b = bestOf(runs, [&] {
+        size_t sum = 0;
+        for (size_t i = 0; i < idx.length; i += 7) sum += utf8ByteOffset(text, idx, i);
+        sink = sum;
+    });
+    std::printf("  offset (1 ogni 7 codepoint)           %8.3f ms\n", b);
+}
+
+int main(int argc, char* argv[]) {
+    size_t mb = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1;
+    size_t size = mb * 1024 * 1024;
+
+    std::string ascii, mixed, wide;
+    while (ascii.size() < size) ascii += "The quick brown fox jumps over the lazy dog. ";
+    while (mixed.size() < size) mixed += "Perché però è già così: caffè, città, 1€. ";
+    while (wide.size() < size) wide += "日本語のテキスト𝄞";
+
+    std::printf("Kernel attivi: %s\n", utf8_kernels::active().name);
+    run("ASCII", ascii);
+    run("Misto (latino + €)", mixed);
+    run("CJK + 4 byte", wide);
+    return 0;
+}
@@ -6,10 +6,77 @@
 #include <memory>
 #include <unordered_map>
 #include "lexer.h"
+#include "value.h"
+#include "operators.h"
+#include "symbols.h"
+
+struct FrameLayout;
+
+// Tipo di nodo AST: usato per il dispatch (switch) in Interpreter e CPPTranspiler
+enum class NodeKind {
+    Unknown,
+
+    // Struttura
+    Program, Body, ExprStmt, Echo,
+
+    // Dichiarazioni
+    VarDecl, ArrayDecl, ArrayInit, ArrayAssign, Assign,
+    FunctionDef, Param, Lambda,
+
+    // Controllo flusso
+    IfExpr, While, ForIn,
+
+    // Espressioni
+    Literal, Identifier, BinaryOp, LogicalOp, UnaryOp,
+    CondChain, SimpleCond, Elvis, Filter,
+    Call, CallExpr, ArrayAccess, RangeExpr, Slice, CommaList
+};
+
+inline const char* nodeKindName(NodeKind k) {
+    switch (k) {
+        case NodeKind::Program:     return "Program";
+        case NodeKind::Body:        return "Body";
+        case NodeKind::ExprStmt:    return "ExprStmt";
+        case NodeKind::Echo:        return "Echo";
+        case NodeKind::VarDecl:     return "VarDecl";
+        case NodeKind::ArrayDecl:   return "ArrayDecl";
+        case NodeKind::ArrayInit:   return "ArrayInit";
+        case NodeKind::ArrayAssign: return "ArrayAssign";
+        case NodeKind::Assign:      return "Assign";
+        case NodeKind::FunctionDef: return "FunctionDef";
+        case NodeKind::Param:       return "Param";
+        case NodeKind::Lambda:      return "Lambda";
+        case NodeKind::IfExpr:      return "IfExpr";
+        case NodeKind::While:       return "While";
+        case NodeKind::ForIn:       return "ForIn";
+        case NodeKind::Literal:     return "Literal";
+        case NodeKind::Identifier:  return "Identifier";
+        case NodeKind::BinaryOp:    return "BinaryOp";
+        case NodeKind::LogicalOp:   return "LogicalOp";
+        case NodeKind::UnaryOp:     return "UnaryOp";
+        case NodeKind::CondChain:   return "CondChain";
+        case NodeKind::SimpleCond:  return "SimpleCond";
+        case NodeKind::Elvis:       return "Elvis";
+        case NodeKind::Filter:      return "Filter";
+        case NodeKind::Call:        return "Call";
+        case NodeKind::CallExpr:    return "CallExpr";
+        case NodeKind::ArrayAccess: return "ArrayAccess";
+        case NodeKind::RangeExpr:   return "RangeExpr";
+        case NodeKind::Slice:       return "Slice";
+        case NodeKind::CommaList:   return "CommaList";
+        default:                    return "Unknown";
+    }
+}
 
 struct ASTNode {
-    std::string type;   // es. "Literal", "VarDecl", "BinaryOp", ...
+    NodeKind kind = NodeKind::Unknown;  // usato per il dispatch
+    std::string type;   // es. "Literal", "VarDecl", "BinaryOp", ... (nome leggibile di kind)
     std::string value;  // lessico principale (es. nome variabile, operatore, ecc.)
+    Symbol sym = NO_SYMBOL; // simbolo di value per i nodi che nominano una variabile
+                            // o funzione (Identifier, VarDecl, Call, Param, ...)
+
+    // Parser: variabile "-> var" di While/ForIn (extra["returnVar"] come simbolo)
+    Symbol returnVar = NO_SYMBOL;
     std::vector<std::shared_ptr<ASTNode>> children;
     std::unordered_map<std::string, std::string> extra;
 
@@ -17,6 +84,55 @@ struct ASTNode {
     int line   = 0;
     int column = 0;
     bool condIncomplete = false;
+
+    // Literal: valore già decodificato dal parser (niente stoi/stod in esecuzione)
+    Value literal;
+
+    // Resolver: layout del frame aperto da questo nodo (body di funzione/lambda,
+    // programma, predicato di filter)
+    std::shared_ptr<FrameLayout> frame;
+
+    // Resolver: variabile nominata da value (Identifier, VarDecl, Call, ...)
+    // come (depth, slot) rispetto al frame corrente; slot = -1 → lookup per nome
+    int slot  = -1;
+    int depth = 0;
+
+    // Resolver: Call/CallExpr in posizione di coda nel body di una funzione
+    // (il trampolino dell'Interpreter la esegue senza crescere lo stack)
+    bool tail = false;
+
+    // Resolver: indice della Call nella cache di chiamata dell'Interpreter
+    int callSite = -1;
+
+    // Parser: id del builtin nominato da una Call (BuiltinId, -1 = nessuno)
+    int builtin = -1;
+
+    // Resolver: nessuna variabile né def del programma ha il nome del
+    // builtin, quindi la Call non può essere nascosta a runtime
+    bool builtinOnly = false;
+
+    // Parser: operatore di BinaryOp/LogicalOp/UnaryOp (None = non gestito)
+    Operator op = Operator::None;
+
+    // Resolver: Filter il cui predicato non ha effetti collaterali
+    // (valutabile in parallelo su porzioni dell'array) o Body di una
+    // def pura (risultato determinato solo dagli argomenti)
+    bool pure = false;
+
+    // Resolver: tabella di memo del Body di una def pura e ricorsiva
+    // (indice nelle tabelle dell'Interpreter, -1 = nessuna)
+    int memo = -1;
+
+    // Resolver: Assign "s = s $ a $ b ...": numero di pezzi aggiunti in
+    // coda alla stringa di s, in place se nessuno la riassegna
+    // (0 = assegnamento normale)
+    int append = 0;
+
+    // Imposta kind e il nome leggibile corrispondente
+    void setKind(NodeKind k) {
+        kind = k;
+        type = nodeKindName(k);
+    }
 };
 
 #endif // MAMMUTH_AST_H
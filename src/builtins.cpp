@@ -0,0 +1,36 @@
+#include "builtins.h"
+
+#include <unordered_map>
+
+// Nomi nell'ordine di BuiltinId
+static const char* const builtinNames[BUILTIN_COUNT] = {
+    "str",
+    "len",
+    "randInt",
+    "randDouble",
+    "array_push",
+    "array_pop",
+    "array_length",
+    "array_first",
+    "array_last",
+    "toInt",
+    "toDouble",
+    "typeOf",
+    "input",
+    "range",
+};
+
+int findBuiltin(const std::string& name) {
+    static const std::unordered_map<std::string, int> index = [] {
+        std::unordered_map<std::string, int> m;
+        for (int id = 0; id < BUILTIN_COUNT; ++id) m[builtinNames[id]] = id;
+        return m;
+    }();
+
+    auto it = index.find(name);
+    return it != index.end() ? it->second : -1;
+}
+
+const char* builtinName(int id) {
+    return (id >= 0 && id < BUILTIN_COUNT) ? builtinNames[id] : "";
+}
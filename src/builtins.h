@@ -0,0 +1,37 @@
+#ifndef MAMMUTH_BUILTINS_H
+#define MAMMUTH_BUILTINS_H
+
+#include <string>
+
+// ============================================================
+// Builtin Mammuth: registro nome → id.
+// Il parser lega ogni Call al suo id (ASTNode::builtin); arità,
+// valutazione degli argomenti e implementazione sono nella
+// tabella Interpreter::builtins, nello stesso ordine.
+// ============================================================
+enum class BuiltinId : int {
+    Str,
+    Len,
+    RandInt,
+    RandDouble,
+    ArrayPush,
+    ArrayPop,
+    ArrayLength,
+    ArrayFirst,
+    ArrayLast,
+    ToInt,
+    ToDouble,
+    TypeOf,
+    Input,
+    Range,
+    Count
+};
+
+constexpr int BUILTIN_COUNT = static_cast<int>(BuiltinId::Count);
+
+// Id del builtin con questo nome, -1 se non esiste
+int findBuiltin(const std::string& name);
+
+const char* builtinName(int id);
+
+#endif // MAMMUTH_BUILTINS_H
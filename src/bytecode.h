@@ -0,0 +1,67 @@
+#ifndef MAMMUTH_BYTECODE_H
+#define MAMMUTH_BYTECODE_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+#include "ast.h"
+#include "value.h"
+
+// ============================================================
+// Bytecode Mammuth (engine --engine=vm)
+// Macchina a stack: ogni espressione lascia esattamente un
+// valore sullo stack degli operandi.
+// ============================================================
+enum class OpCode : uint8_t {
+    CONST,          // push constants[a]
+    LOAD,           // push variabile names[a] (per nome)
+    LOAD_VAR,       // push variabile nominata da nodes[a] (lookup del Resolver)
+    LOAD_SLOT,      // push slot c del frame a profondità b (nodes[a] se non definito)
+    DEFINE,         // pop → definisce la variabile di nodes[a] (b = flag DEFINE_*)
+    STORE,          // assegna la variabile di nodes[a] = top (il valore resta sullo stack)
+    STORE_SLOT,     // come STORE sullo slot c a profondità b
+    STORE_SLOT_POP, // STORE_SLOT + POP (assegnamento come statement)
+    POP,            // scarta top
+    BINARY,         // pop right, left → push left <op> right   (a = nodo)
+    ADD, SUB, MUL, DIV, MOD,        // come BINARY, con int/double calcolati nel VM
+    LT, LE, GT, GE, EQ, NE,
+    UNARY,          // pop val → push <op> val                  (a = nodo)
+    JUMP,           // ip = a
+    JUMP_IF_FALSE,  // pop cond; se falsa ip = a
+    JUMP_UNLESS_LT, JUMP_UNLESS_LE, JUMP_UNLESS_GT,     // confronto (a = nodo) + JUMP_IF_FALSE
+    JUMP_UNLESS_GE, JUMP_UNLESS_EQ, JUMP_UNLESS_NE,     // con destinazione in b
+    PRINT,          // stampa top + newline (il valore resta)
+    EVAL,           // push Interpreter::eval(nodes[a])  (nodi non compilati)
+    EXEC,           // Interpreter::execStatement(nodes[a], top); b = 1: valore scartato
+    CALL_PREPARE,   // risolve la Call nodes[a]; se non servono argomenti push risultato e ip = b
+    CALL,           // pop b argomenti → push risultato della Call preparata (a = nodo)
+    LOAD_ARRAY,     // push array di nodes[a] (formato varname[i]); se non definito push 0 e ip = b
+    INDEX,          // pop indice, array → push array[indice]   (a = nodo)
+    ITER_START,     // pop collezione → stack iteratori (a = uscita, b = nodo)
+    ITER_NEXT,      // definisce la variabile di nodes[b] = prossimo elemento o salta ad a
+    RETURN          // termina il chunk restituendo top
+};
+
+// Flag per DEFINE
+constexpr int DEFINE_DYNAMIC = 1;
+constexpr int DEFINE_FIXED   = 2;
+
+struct Instruction {
+    OpCode op;
+    int a = 0;
+    int b = 0;
+    int c = 0;
+};
+
+// Unità di codice compilato (un Program o il Body di una funzione)
+struct Chunk {
+    std::vector<Instruction> code;
+    std::vector<Value> constants;                   // pool costanti
+    std::vector<Symbol> names;                      // simboli delle variabili (LOAD)
+    std::vector<std::shared_ptr<ASTNode>> nodes;    // nodi per EVAL/EXEC e messaggi d'errore
+    int maxStack = 0;                               // profondità massima dello stack operandi
+};
+
+#endif // MAMMUTH_BYTECODE_H
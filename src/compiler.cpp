@@ -0,0 +1,484 @@
+#include "compiler.h"
+#include "debug.h"
+
+// ============================================================
+// Entry point
+// ============================================================
+std::unique_ptr<Chunk> BytecodeCompiler::compile(const std::shared_ptr<ASTNode>& node) {
+    auto out = std::make_unique<Chunk>();
+    chunk = out.get();
+    nameIndex.clear();
+    depth = 0;
+
+    compileExpr(node);
+    emit(OpCode::RETURN);
+
+    DEBUG_INTERP_LOG("Bytecode: " << out->code.size() << " istruzioni, "
+                     << out->constants.size() << " costanti");
+    chunk = nullptr;
+    return out;
+}
+
+// ============================================================
+// Emissione
+// ============================================================
+// Valori aggiunti (o tolti) dallo stack operandi da un'istruzione
+static int stackEffect(OpCode op, int b) {
+    switch (op) {
+        case OpCode::CONST:
+        case OpCode::LOAD:
+        case OpCode::LOAD_VAR:
+        case OpCode::LOAD_SLOT:
+        case OpCode::EVAL:
+        case OpCode::LOAD_ARRAY:
+            return 1;
+        case OpCode::DEFINE:
+        case OpCode::STORE_SLOT_POP:
+        case OpCode::POP:
+        case OpCode::BINARY:
+        case OpCode::ADD: case OpCode::SUB: case OpCode::MUL:
+        case OpCode::DIV: case OpCode::MOD:
+        case OpCode::LT: case OpCode::LE: case OpCode::GT:
+        case OpCode::GE: case OpCode::EQ: case OpCode::NE:
+        case OpCode::JUMP_IF_FALSE:
+        case OpCode::INDEX:
+        case OpCode::ITER_START:
+        case OpCode::RETURN:
+            return -1;
+        case OpCode::JUMP_UNLESS_LT: case OpCode::JUMP_UNLESS_LE:
+        case OpCode::JUMP_UNLESS_GT: case OpCode::JUMP_UNLESS_GE:
+        case OpCode::JUMP_UNLESS_EQ: case OpCode::JUMP_UNLESS_NE:
+            return -2;
+        case OpCode::CALL:
+            return 1 - b;
+        default:
+            return 0;
+    }
+}
+
+// La profondità segue il codice in ordine lineare: nei rami di if e
+// cicli è al più sovrastimata, quindi maxStack resta un limite sicuro
+int BytecodeCompiler::emit(OpCode op, int a, int b, int c) {
+    chunk->code.push_back({op, a, b, c});
+    depth += stackEffect(op, b);
+    if (depth > chunk->maxStack) chunk->maxStack = depth;
+    return static_cast<int>(chunk->code.size()) - 1;
+}
+
+int BytecodeCompiler::here() const {
+    return static_cast<int>(chunk->code.size());
+}
+
+// Istruzioni di salto che hanno il nodo in a e la destinazione in b
+static bool targetInB(OpCode op) {
+    switch (op) {
+        case OpCode::CALL_PREPARE:
+        case OpCode::LOAD_ARRAY:
+        case OpCode::JUMP_UNLESS_LT: case OpCode::JUMP_UNLESS_LE:
+        case OpCode::JUMP_UNLESS_GT: case OpCode::JUMP_UNLESS_GE:
+        case OpCode::JUMP_UNLESS_EQ: case OpCode::JUMP_UNLESS_NE:
+            return true;
+        default:
+            return false;
+    }
+}
+
+void BytecodeCompiler::patch(int at, int target) {
+    Instruction& in = chunk->code[at];
+    if (targetInB(in.op))
+        in.b = target;
+    else
+        in.a = target;
+}
+
+// Salto condizionato sul valore appena calcolato: se è un confronto,
+// confronto e salto diventano un'unica istruzione (stesso indice, quindi
+// i salti che vi arrivano restano validi). Restituisce l'istruzione da
+// completare con patch()
+int BytecodeCompiler::emitJumpIfFalse() {
+    if (!chunk->code.empty()) {
+        Instruction& last = chunk->code.back();
+        OpCode fused;
+        switch (last.op) {
+            case OpCode::LT: fused = OpCode::JUMP_UNLESS_LT; break;
+            case OpCode::LE: fused = OpCode::JUMP_UNLESS_LE; break;
+            case OpCode::GT: fused = OpCode::JUMP_UNLESS_GT; break;
+            case OpCode::GE: fused = OpCode::JUMP_UNLESS_GE; break;
+            case OpCode::EQ: fused = OpCode::JUMP_UNLESS_EQ; break;
+            case OpCode::NE: fused = OpCode::JUMP_UNLESS_NE; break;
+            default: return emit(OpCode::JUMP_IF_FALSE);
+        }
+        last.op = fused;
+        depth -= 1;     // il risultato del confronto non resta sullo stack
+        return static_cast<int>(chunk->code.size()) - 1;
+    }
+    return emit(OpCode::JUMP_IF_FALSE);
+}
+
+int BytecodeCompiler::addConstant(const Value& v) {
+    chunk->constants.push_back(v);
+    return static_cast<int>(chunk->constants.size()) - 1;
+}
+
+int BytecodeCompiler::addName(Symbol name) {
+    auto it = nameIndex.find(name);
+    if (it != nameIndex.end()) return it->second;
+    int idx = static_cast<int>(chunk->names.size());
+    chunk->names.push_back(name);
+    nameIndex[name] = idx;
+    return idx;
+}
+
+int BytecodeCompiler::addNode(const std::shared_ptr<ASTNode>& node) {
+    chunk->nodes.push_back(node);
+    return static_cast<int>(chunk->nodes.size()) - 1;
+}
+
+// Operatori con un'istruzione propria (fast path numerico nel VM)
+static OpCode binaryOpCode(Operator op) {
+    switch (op) {
+        case Operator::Add: return OpCode::ADD;
+        case Operator::Sub: return OpCode::SUB;
+        case Operator::Mul: return OpCode::MUL;
+        case Operator::Div: return OpCode::DIV;
+        case Operator::Mod: return OpCode::MOD;
+        case Operator::Lt:  return OpCode::LT;
+        case Operator::Le:  return OpCode::LE;
+        case Operator::Gt:  return OpCode::GT;
+        case Operator::Ge:  return OpCode::GE;
+        case Operator::Eq:  return OpCode::EQ;
+        case Operator::Ne:  return OpCode::NE;
+        default:            return OpCode::BINARY;
+    }
+}
+
+// ============================================================
+// Espressioni: lasciano sempre un valore sullo stack
+// ============================================================
+void BytecodeCompiler::compileExpr(const std::shared_ptr<ASTNode>& node) {
+    if (!node) {
+        emit(OpCode::CONST, addConstant(0));
+        return;
+    }
+
+    switch (node->kind) {
+        case NodeKind::Literal:
+            emit(OpCode::CONST, addConstant(node->literal));
+            return;
+
+        case NodeKind::Identifier:
+            if (node->slot >= 0)
+                emit(OpCode::LOAD_SLOT, addNode(node), node->depth, node->slot);
+            else
+                emit(OpCode::LOAD_VAR, addNode(node));
+            return;
+
+        case NodeKind::BinaryOp:
+        case NodeKind::LogicalOp: {
+            // "$" con RangeExpr a destra: slicing gestito dall'Interpreter
+            if (node->children.size() != 2 ||
+                (node->children[1] && node->children[1]->kind == NodeKind::RangeExpr))
+                break;
+
+            compileExpr(node->children[0]);
+            compileExpr(node->children[1]);
+            emit(binaryOpCode(node->op), addNode(node));
+            return;
+        }
+
+        case NodeKind::Call:
+            compileCall(node);
+            return;
+
+        case NodeKind::ArrayAccess:
+            if (compileArrayAccess(node)) return;
+            break;
+
+        case NodeKind::UnaryOp:
+            if (node->children.empty()) break;
+            compileExpr(node->children[0]);
+            emit(OpCode::UNARY, addNode(node));
+            return;
+
+        case NodeKind::Assign:
+            // Solo assegnamento semplice; arr[i] = v e l'append
+            // in place (s = s $ ...) restano all'Interpreter
+            if (node->children.size() < 2 ||
+                node->children[0]->kind != NodeKind::Identifier ||
+                node->append > 0)
+                break;
+            compileExpr(node->children[1]);
+            if (node->children[0]->slot >= 0)
+                emit(OpCode::STORE_SLOT, addNode(node->children[0]),
+                     node->children[0]->depth, node->children[0]->slot);
+            else
+                emit(OpCode::STORE, addNode(node->children[0]));
+            return;
+
+        case NodeKind::CommaList: {
+            emit(OpCode::CONST, addConstant(0));
+            for (auto& ch : node->children) {
+                emit(OpCode::POP);
+                compileExpr(ch);
+            }
+            return;
+        }
+
+        case NodeKind::IfExpr:
+            if (node->children.size() < 2) break;
+            compileIf(node);
+            return;
+
+        case NodeKind::While:
+            if (node->children.size() < 2) break;
+            compileWhile(node);
+            return;
+
+        case NodeKind::ForIn:
+            if (node->children.size() < 2) break;
+            compileForIn(node);
+            return;
+
+        case NodeKind::Program: {
+            emit(OpCode::CONST, addConstant(0));
+            for (auto& st : node->children) {
+                emit(OpCode::POP);
+                compileExpr(st);
+            }
+            return;
+        }
+
+        case NodeKind::Body:
+            compileBody(node);
+            return;
+
+        default:
+            break;
+    }
+
+    // Fallback: il nodo viene valutato dal tree-walker
+    emit(OpCode::EVAL, addNode(node));
+}
+
+// Call per nome: destinazione risolta prima degli argomenti, come in
+// eval(); se la chiamata non ha argomenti da valutare (builtin Raw,
+// arità errata, funzione non definita) CALL_PREPARE salta oltre CALL
+void BytecodeCompiler::compileCall(const std::shared_ptr<ASTNode>& node) {
+    int nodeIdx = addNode(node);
+    int prepare = emit(OpCode::CALL_PREPARE, nodeIdx);
+    for (auto& ch : node->children) compileExpr(ch);
+    emit(OpCode::CALL, nodeIdx, static_cast<int>(node->children.size()));
+    patch(prepare, here());
+}
+
+// arr[i] con indice singolo (gli slice restano all'Interpreter)
+bool BytecodeCompiler::compileArrayAccess(const std::shared_ptr<ASTNode>& node) {
+    if (node->value.empty()) {
+        // Formato expr[index]
+        if (node->children.size() != 2 || !node->children[1] ||
+            node->children[1]->kind == NodeKind::RangeExpr)
+            return false;
+        compileExpr(node->children[0]);
+        compileExpr(node->children[1]);
+        emit(OpCode::INDEX, addNode(node));
+        return true;
+    }
+
+    // Formato varname[index]
+    if (node->children.size() != 1 || !node->children[0] ||
+        node->children[0]->kind == NodeKind::RangeExpr)
+        return false;
+    int nodeIdx = addNode(node);
+    int load = emit(OpCode::LOAD_ARRAY, nodeIdx);
+    compileExpr(node->children[0]);
+    emit(OpCode::INDEX, nodeIdx);
+    patch(load, here());
+    return true;
+}
+
+// ============================================================
+// Body: sullo stack resta il valore "last" del blocco
+// ============================================================
+void BytecodeCompiler::compileBody(const std::shared_ptr<ASTNode>& node) {
+    emit(OpCode::CONST, addConstant(0));
+    for (auto& st : node->children) {
+        if (!st) continue;
+        compileStatement(st);
+    }
+}
+
+void BytecodeCompiler::compileStatement(const std::shared_ptr<ASTNode>& st) {
+    switch (st->kind) {
+        case NodeKind::ExprStmt:
+            emit(OpCode::POP);
+            compileExpr(st->children[0]);
+            return;
+
+        case NodeKind::Echo:
+            emit(OpCode::POP);
+            compileExpr(st->children[0]);
+            emit(OpCode::PRINT);
+            return;
+
+        case NodeKind::Assign:
+        case NodeKind::While:
+        case NodeKind::ForIn:
+            emit(OpCode::POP);
+            compileExpr(st);
+            return;
+
+        case NodeKind::VarDecl: {
+            int flags = 0;
+            if (st->extra.count("dynamic") && st->extra.at("dynamic") == "true")
+                flags |= DEFINE_DYNAMIC;
+            if (st->extra.count("fixed") && st->extra.at("fixed") == "true")
+                flags |= DEFINE_FIXED;
+
+            if (st->children.empty())
+                emit(OpCode::CONST, addConstant(0));
+            else
+                compileExpr(st->children[0]);
+            emit(OpCode::DEFINE, addNode(st), flags);
+            return;
+        }
+
+        default:
+            // FunctionDef, ArrayDecl, ArrayAssign, ... → Interpreter
+            emit(OpCode::EXEC, addNode(st));
+            return;
+    }
+}
+
+// Body di un ciclo: il suo valore viene scartato, quindi gli statement
+// non tengono "last" sullo stack
+void BytecodeCompiler::compileLoopBody(const std::shared_ptr<ASTNode>& node) {
+    if (!node || node->kind != NodeKind::Body) {
+        compileExpr(node);
+        emit(OpCode::POP);
+        return;
+    }
+    for (auto& st : node->children) {
+        if (st) compileEffect(st);
+    }
+}
+
+// Statement di cui conta solo l'effetto: non lascia nulla sullo stack
+void BytecodeCompiler::compileEffect(const std::shared_ptr<ASTNode>& st) {
+    switch (st->kind) {
+        case NodeKind::ExprStmt:
+            compileExpr(st->children[0]);
+            emit(OpCode::POP);
+            return;
+
+        case NodeKind::Echo:
+            compileExpr(st->children[0]);
+            emit(OpCode::PRINT);
+            emit(OpCode::POP);
+            return;
+
+        case NodeKind::Assign:
+            compileExpr(st);
+            // STORE_SLOT + POP in un'istruzione sola
+            if (chunk->code.back().op == OpCode::STORE_SLOT) {
+                chunk->code.back().op = OpCode::STORE_SLOT_POP;
+                depth -= 1;
+            } else {
+                emit(OpCode::POP);
+            }
+            return;
+
+        case NodeKind::While:
+        case NodeKind::ForIn:
+            compileExpr(st);
+            emit(OpCode::POP);
+            return;
+
+        case NodeKind::VarDecl:
+            compileStatement(st);
+            return;
+
+        default:
+            emit(OpCode::EXEC, addNode(st), 1);
+            return;
+    }
+}
+
+// ============================================================
+// Controllo flusso
+// ============================================================
+void BytecodeCompiler::compileIf(const std::shared_ptr<ASTNode>& node) {
+    int elifCount = 0;
+    bool hasElse = false;
+
+    if (node->extra.count("elifCount"))
+        elifCount = std::stoi(node->extra.at("elifCount"));
+    if (node->extra.count("hasElse"))
+        hasElse = (node->extra.at("hasElse") == "true");
+
+    std::vector<int> exits;
+
+    // if
+    compileExpr(node->children[0]);
+    int skip = emitJumpIfFalse();
+    compileExpr(node->children[1]);
+    exits.push_back(emit(OpCode::JUMP));
+    patch(skip, here());
+
+    // elif
+    size_t childIdx = 2;
+    for (int i = 0; i < elifCount; i++) {
+        if (childIdx + 1 >= node->children.size()) break;
+
+        compileExpr(node->children[childIdx]);
+        int next = emitJumpIfFalse();
+        compileExpr(node->children[childIdx + 1]);
+        exits.push_back(emit(OpCode::JUMP));
+        patch(next, here());
+        childIdx += 2;
+    }
+
+    // else (o 0 se nessun ramo è stato preso)
+    size_t elseIdx = 2 + (elifCount * 2);
+    if (hasElse && elseIdx < node->children.size())
+        compileExpr(node->children[elseIdx]);
+    else
+        emit(OpCode::CONST, addConstant(0));
+
+    for (int at : exits) patch(at, here());
+}
+
+// Dopo ogni iterazione: se c'è "-> var" il valore del loop diventa var
+void BytecodeCompiler::compileReturnVar(const std::shared_ptr<ASTNode>& node) {
+    if (node->returnVar == NO_SYMBOL) return;
+    emit(OpCode::POP);
+    emit(OpCode::LOAD, addName(node->returnVar));
+}
+
+void BytecodeCompiler::compileWhile(const std::shared_ptr<ASTNode>& node) {
+    emit(OpCode::CONST, addConstant(0));   // valore del loop
+
+    int loop = here();
+    compileExpr(node->children[0]);
+    int exit = emitJumpIfFalse();
+
+    compileLoopBody(node->children[1]);
+    compileReturnVar(node);
+    emit(OpCode::JUMP, loop);
+
+    patch(exit, here());
+}
+
+void BytecodeCompiler::compileForIn(const std::shared_ptr<ASTNode>& node) {
+    emit(OpCode::CONST, addConstant(0));   // valore del loop
+
+    compileExpr(node->children[0]);
+    int start = emit(OpCode::ITER_START, 0, addNode(node));
+
+    int loop = emit(OpCode::ITER_NEXT, 0, addNode(node));
+    compileLoopBody(node->children[1]);
+    compileReturnVar(node);
+    emit(OpCode::JUMP, loop);
+
+    patch(start, here());
+    patch(loop, here());
+}
@@ -0,0 +1,52 @@
+#ifndef MAMMUTH_COMPILER_H
+#define MAMMUTH_COMPILER_H
+
+#include <string>
+#include <memory>
+#include <unordered_map>
+
+#include "ast.h"
+#include "bytecode.h"
+
+// ============================================================
+// Compilatore AST → bytecode
+// Variabili risolte dal Resolver, operatori, chiamate per nome e
+// arr[i] sono tradotti in istruzioni; i nodi senza una traduzione
+// dedicata (lambda, filter, slice, ...) diventano EVAL e restano al
+// tree-walker, così l'output è identico a quello dell'Interpreter.
+// ============================================================
+class BytecodeCompiler {
+public:
+    // Compila un Program o un Body: il chunk restituisce il valore del nodo
+    std::unique_ptr<Chunk> compile(const std::shared_ptr<ASTNode>& node);
+
+private:
+    Chunk* chunk = nullptr;
+    std::unordered_map<Symbol, int> nameIndex;
+    int depth = 0;      // profondità dello stack dopo l'ultima istruzione emessa
+
+    // Emissione (aggiorna depth e chunk->maxStack)
+    int emit(OpCode op, int a = 0, int b = 0, int c = 0);
+    int emitJumpIfFalse();
+    int here() const;
+    void patch(int at, int target);
+
+    int addConstant(const Value& v);
+    int addName(Symbol name);
+    int addNode(const std::shared_ptr<ASTNode>& node);
+
+    // Traduzione
+    void compileExpr(const std::shared_ptr<ASTNode>& node);
+    void compileBody(const std::shared_ptr<ASTNode>& node);
+    void compileStatement(const std::shared_ptr<ASTNode>& st);
+    void compileLoopBody(const std::shared_ptr<ASTNode>& node);
+    void compileEffect(const std::shared_ptr<ASTNode>& st);
+    void compileCall(const std::shared_ptr<ASTNode>& node);
+    bool compileArrayAccess(const std::shared_ptr<ASTNode>& node);
+    void compileIf(const std::shared_ptr<ASTNode>& node);
+    void compileWhile(const std::shared_ptr<ASTNode>& node);
+    void compileForIn(const std::shared_ptr<ASTNode>& node);
+    void compileReturnVar(const std::shared_ptr<ASTNode>& node);
+};
+
+#endif // MAMMUTH_COMPILER_H
@@ -1,6 +1,8 @@
  #include "driver.h"
+#include <algorithm>
 #include <iostream>
 #include <fstream>
+#include <thread>
 
 
 bool Driver::parseArguments(int argc, char* argv[]) {
@@ -21,11 +23,36 @@ bool Driver::parseArguments(int argc, char* argv[]) {
         else if (arg == "--dump-errors") opts.dump_errors = true;
         else if (arg == "--keep-temp") opts.keep_temp = true;
         else if (arg == "--no-run") opts.no_run = true;
+        else if (arg == "--no-memo") opts.memo = false;
+        else if (arg == "--memo-stats") opts.memo_stats = true;
+        else if (arg == "--no-opt") opts.optimize = false;
         else if (arg == "--run") opts.run = true;
         else if (arg == "--compile") opts.compile = true;
         else if (arg == "--backend" && i + 1 < argc) opts.backend = argv[++i];
         else if (arg == "--out" && i + 1 < argc) opts.output_file = argv[++i];
         else if (arg == "--errors" && i + 1 < argc) opts.errors_module = argv[++i];
+        else if (arg.rfind("--engine=", 0) == 0) opts.engine = arg.substr(9);
+        else if (arg.rfind("--threads=", 0) == 0) {
+            std::string n = arg.substr(10);
+            if (n.empty() || n.find_first_not_of("0123456789") != std::string::npos) {
+                std::cerr << "Numero di thread non valido: " << n << "\n";
+                return false;
+            }
+            // Limite: qualche thread per core (hardware_concurrency() può dare 0)
+            unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+            unsigned long maxThreads = cores * 4ul;
+            unsigned long value = 0;
+            for (char c : n) {
+                value = value * 10 + static_cast<unsigned long>(c - '0');
+                if (value > maxThreads) break;
+            }
+            if (value > maxThreads) {
+                std::cerr << "Numero di thread troppo alto: " << n
+                          << " (massimo " << maxThreads << ")\n";
+                return false;
+            }
+            opts.threads = value == 0 ? cores : static_cast<unsigned>(value);
+        }
         else if (arg[0] != '-') opts.input_file = arg;
         else {
             std::cerr << "Opzione sconosciuta: " << arg << "\n";
@@ -41,6 +68,10 @@ bool Driver::parseArguments(int argc, char* argv[]) {
         printVersion();
         return false;
     }
+    if (opts.engine != "ast" && opts.engine != "vm") {
+        std::cerr << "Engine sconosciuto: " << opts.engine << " (usa ast o vm)\n";
+        return false;
+    }
     if (opts.input_file.empty()) {
         std::cerr << "Nessun file sorgente specificato.\n";
         return false;
@@ -54,9 +85,14 @@ void Driver::printHelp() const {
         "Uso: mammuthc [opzioni] file.mmt\n\n"
         "Opzioni principali:\n"
         "  --run              Esegue il programma (default)\n"
+        "  --engine=<e>       Engine di esecuzione: ast (default) o vm (bytecode)\n"
+        "  --threads=<n>      Thread per i filter (=>) con predicato puro (0 = tutti i core)\n"
+        "  --no-memo          Disattiva la memo delle funzioni pure ricorsive\n"
+        "  --memo-stats       Mostra hit/miss della memo a fine esecuzione\n"
         "  --check            Controlla sintassi e tipi\n"
         "  --tokens           Mostra token\n"
-        "  --ast              Mostra AST\n"
+        "  --ast              Mostra AST (dopo l'ottimizzazione)\n"
+        "  --no-opt           Disattiva folding delle costanti e rami morti\n"
         "  --errors <mod>     Usa <mod>.err per la gestione errori\n"
         "  --dump-errors      Elenca gestori errori caricati\n"
         "  --compile          Genera codice C++ e compila\n"
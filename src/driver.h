@@ -17,8 +17,13 @@ struct Options {
     bool dump_errors = false;
     bool keep_temp = false;
     bool no_run = false;
+    unsigned threads = 1;           // thread per i filter paralleli (0 = tutti i core)
+    bool memo = true;               // memo delle def pure ricorsive
+    bool memo_stats = false;
+    bool optimize = true;           // Optimizer tra parser ed esecuzione
 
     std::string backend = "gcc";
+    std::string engine = "ast";     // ast (tree-walker) | vm (bytecode)
     std::string errors_module;
     std::string output_file = "a.out";
     std::string input_file;
@@ -3,12 +3,16 @@
 #include "value.h"
 #include "range.h"  // ⭐ NUOVO
 #include "utf8.h"   // per slicing stringhe UTF-8
+#include "vm.h"
+#include "thread_pool.h"
 
 #include <algorithm>
 #include <iostream>
 #include <sstream>
 #include <cmath>
 #include <cstdlib>  // rand(), srand()
+#include <cstdio>   // snprintf
+#include <cstring>  // strcmp
 #include <ctime>    // time()
 #include <memory>
 
@@ -27,12 +31,8 @@ static std::string typeOfValue(const Value& v) {
 
 // helper per creare un ArrayValue di N zeri
 static ArrayValue makeArrayOfSize(int size) {
-    ArrayValue arr;
     if (size < 0) size = 0;
-    for (int i = 0; i < size; ++i) {
-        arr.push_back(std::make_shared<Value>(0));
-    }
-    return arr;
+    return ArrayValue(std::vector<int>(size, 0));
 }
 
 // helper per espandere inizializzatori di array che contengono CommaList
@@ -43,7 +43,7 @@ static void appendArrayInitExpr(Interpreter* interp,
     if (!expr) return;
 
     // Se l'espressione è una lista separata da virgole, espandi ricorsivamente
-    if (expr->type == "CommaList") {
+    if (expr->kind == NodeKind::CommaList) {
         for (auto& sub : expr->children) {
             appendArrayInitExpr(interp, out, sub);
         }
@@ -51,16 +51,13 @@ static void appendArrayInitExpr(Interpreter* interp,
     }
 
     // Caso base: espressione normale → valuta e aggiungi all'array
-    Value v = interp->eval(expr);
+    const Value v = interp->eval(expr);
 
     // ⭐ NUOVO: Se il valore è un array, espandi i suoi elementi
     if (isType<ArrayValue>(v)) {
-        auto& arr = as<ArrayValue>(v);
-        for (auto& elem : arr.elements) {
-            out.push_back(elem);  // Aggiungi ogni elemento dell'array
-        }
+        out.append(as<ArrayValue>(v));  // Aggiungi ogni elemento dell'array
     } else {
-        out.push_back(std::make_shared<Value>(v));
+        out.push_back(v);
     }
 }
 
@@ -76,17 +73,47 @@ Interpreter::Interpreter() {
     DEBUG_INTERP_LOG("Interpreter creato, scope globale inizializzato");
 }
 
+Interpreter::Interpreter(const Interpreter& owner) {
+    borrowScopes(owner);
+    DEBUG_INTERP_LOG("Interpreter worker creato su " << borrowedScopes << " scope");
+}
+
+void Interpreter::borrowScopes(const Interpreter& owner) {
+    // Tra due filter gli scope propri sono tutti tornati nel pool
+    scopes = owner.scopes;
+    borrowedScopes = scopes.size();
+    functions = owner.functions;
+    invalidateCallCaches();
+}
+
+void Interpreter::setThreads(unsigned n) {
+    threads = n ? n : 1;
+    filterWorkers.clear();
+    filterPool.reset();
+    if (threads > 1) filterPool = std::make_unique<ThreadPool>(threads - 1);
+}
+
 Interpreter::~Interpreter() {
-    for (auto* s : scopes) delete s;
+    for (size_t i = borrowedScopes; i < scopes.size(); ++i) delete scopes[i];
+    for (auto* s : freeScopes) delete s;
 }
 
 Scope& Interpreter::currentScope() {
     return *scopes.back();
 }
 
-void Interpreter::pushScope() {
+void Interpreter::pushScope(const FrameLayout* layout) {
     Scope* parent = scopes.empty() ? nullptr : scopes.back();
-    Scope* s = new Scope(parent);
+
+    // Riusa uno scope dal pool: niente new/delete per chiamata o elemento di filter
+    Scope* s;
+    if (!freeScopes.empty()) {
+        s = freeScopes.back();
+        freeScopes.pop_back();
+        s->reset(parent, layout);
+    } else {
+        s = new Scope(parent, layout);
+    }
     scopes.push_back(s);
     DEBUG_SCOPE_LOG("pushScope, depth=" << scopes.size());
 }
@@ -99,50 +126,76 @@ void Interpreter::popScope() {
     DEBUG_SCOPE_LOG("popScope, depth=" << scopes.size());
     Scope* s = scopes.back();
     scopes.pop_back();
-    delete s;
+    if (!s->localFunctions.empty()) invalidateCallCaches();
+    s->release();
+    freeScopes.push_back(s);
+}
+
+// =======================
+// Closure
+// =======================
+
+// Cattura dallo scope corrente le variabili libere di un body.
+// Senza layout (AST non risolto) cattura tutte le variabili visibili.
+std::shared_ptr<const CapturedEnv> Interpreter::captureFor(const std::shared_ptr<ASTNode>& body) {
+    auto env = std::make_shared<CapturedEnv>();
+    Scope& current = currentScope();
+
+    if (body && body->frame) {
+        const FrameLayout& layout = *body->frame;
+        for (int slot : layout.captures) {
+            Symbol name = layout.names[slot];
+            if (StoredVar* sv = current.lookup(name))
+                env->vars.push_back({name, slot, sv->value});
+        }
+    } else {
+        std::unordered_map<Symbol, Value> all;
+        for (Scope* s = &current; s; s = s->parent) {
+            // Non sovrascrivere se già catturata da scope più vicino
+            s->forEachVar([&](Symbol name, const StoredVar& sv) {
+                all.emplace(name, sv.value);
+            });
+        }
+        for (auto& pair : all)
+            env->vars.push_back({pair.first, -1, pair.second});
+    }
+
+    if (env->vars.empty()) return nullptr;
+    return env;
+}
+
+// Ripristina l'ambiente catturato nello scope della chiamata
+void Interpreter::bindCaptured(const std::shared_ptr<const CapturedEnv>& env) {
+    if (!env) return;
+    Scope& scope = currentScope();
+    for (const auto& cv : env->vars) {
+        StoredVar sv;
+        sv.value = cv.value;
+        if (cv.slot >= 0 && cv.slot < static_cast<int>(scope.slots.size()))
+            scope.defineSlot(cv.slot, sv);
+        else
+            scope.define(cv.name, sv);
+    }
 }
 
-Value Interpreter::lookup(const std::string& name) {
+Value Interpreter::lookup(Symbol name) {
     // Prima cerca in variabili
     StoredVar* sv = currentScope().lookup(name);
     if (sv) {
-        DEBUG_SCOPE_LOG("lookup '" << name << "' OK");
+        DEBUG_SCOPE_LOG("lookup '" << symbolName(name) << "' OK");
         return sv->value;
     }
     
     // Poi cerca in funzioni locali (nested)
     auto localFunc = currentScope().lookupLocalFunction(name);
     if (localFunc) {
-        DEBUG_SCOPE_LOG("lookup function '" << name << "' OK (local)");
+        DEBUG_SCOPE_LOG("lookup function '" << symbolName(name) << "' OK (local)");
         
         // Converti FunctionDef in FunctionValue
-        FunctionValue fv;
-        
-        // Estrai parametri
-        for (auto& child : localFunc->children) {
-            if (child->type == "Param") {
-                fv.params.push_back(child->value);
-            } else if (child->type == "Body") {
-                fv.body = child;
-            }
-        }
-        
-        // Cattura variabili da scope corrente (closure)
-        Scope& current = currentScope();
-        for (const auto& pair : current.vars) {
-            fv.capturedVars[pair.first] = pair.second.value;
-        }
+        FunctionValue fv = functionValueOf(localFunc);
         
-        // Cattura anche da parent scopes
-        Scope* parent = current.parent;
-        while (parent) {
-            for (const auto& pair : parent->vars) {
-                if (fv.capturedVars.find(pair.first) == fv.capturedVars.end()) {
-                    fv.capturedVars[pair.first] = pair.second.value;
-                }
-            }
-            parent = parent->parent;
-        }
+        // Cattura le variabili libere del body dallo scope corrente (closure)
+        fv.capturedVars = captureFor(fv.body);
         
         return fv;
     }
@@ -153,83 +206,155 @@ Value Interpreter::lookup(const std::string& name) {
     // ============================================
     auto it = functions.find(name);
     if (it != functions.end()) {
-        DEBUG_SCOPE_LOG("lookup function '" << name << "' OK (global)");
+        DEBUG_SCOPE_LOG("lookup function '" << symbolName(name) << "' OK (global)");
         
         // Converti FunctionDef in FunctionValue
-        FunctionValue fv;
-        auto funcDef = it->second;
-        
-        // Estrai parametri
-        for (auto& child : funcDef->children) {
-            if (child->type == "Param") {
-                fv.params.push_back(child->value);
-            } else if (child->type == "Body") {
-                fv.body = child;
-            }
-        }
-        
-        // Cattura variabili da scope corrente (per closure)
-        Scope& current = currentScope();
-        for (const auto& pair : current.vars) {
-            fv.capturedVars[pair.first] = pair.second.value;
-        }
+        FunctionValue fv = functionValueOf(it->second);
         
-        // Cattura anche da parent scopes
-        Scope* parent = current.parent;
-        while (parent) {
-            for (const auto& pair : parent->vars) {
-                if (fv.capturedVars.find(pair.first) == fv.capturedVars.end()) {
-                    fv.capturedVars[pair.first] = pair.second.value;
-                }
-            }
-            parent = parent->parent;
-        }
+        // Cattura le variabili libere del body dallo scope corrente (per closure)
+        fv.capturedVars = captureFor(fv.body);
         
         return fv;
     }
     
-    DEBUG_SCOPE_LOG("lookup '" << name << "' non trovato, ritorno 0");
+    DEBUG_SCOPE_LOG("lookup '" << symbolName(name) << "' non trovato, ritorno 0");
     return 0;
 }
 
-void Interpreter::defineVar(const std::string& name, const Value& v, bool isDynamic, bool isFixed) {
+// FunctionValue di una def (parametri e body, senza catture)
+FunctionValue Interpreter::functionValueOf(const std::shared_ptr<ASTNode>& def) {
+    FunctionValue fv;
+    for (auto& child : def->children) {
+        if (child->kind == NodeKind::Param) {
+            fv.params.push_back(child->sym);
+        } else if (child->kind == NodeKind::Body) {
+            fv.body = child;
+        }
+    }
+    return fv;
+}
+
+// =======================
+// Cache di chiamata
+// =======================
+
+// Def chiamata da una Call per nome (locale, poi globale), risolta una
+// volta per epoca; 0 se il nome non è una def
+Value Interpreter::callTargetOf(const ASTNode& call) {
+    CallCache* cache = nullptr;
+    if (call.callSite >= 0) {
+        if (call.callSite >= static_cast<int>(callCaches.size()))
+            callCaches.resize(call.callSite + 1);
+        cache = &callCaches[call.callSite];
+        if (cache->epoch == callEpoch) return cache->target;
+    }
+
+    auto def = currentScope().lookupLocalFunction(call.sym);
+    if (!def) {
+        auto it = functions.find(call.sym);
+        if (it != functions.end()) def = it->second;
+    }
+    Value target = def ? Value(functionValueOf(def)) : Value();
+
+    if (cache) {
+        cache->epoch = callEpoch;
+        cache->target = target;
+        DEBUG_SCOPE_LOG("Call '" << call.value << "' risolta (epoca " << callEpoch << ")");
+    }
+    return target;
+}
+
+void Interpreter::defineVar(Symbol name, const Value& v, bool isDynamic, bool isFixed) {
     StoredVar sv;
     sv.value = v;
     sv.isDynamic = isDynamic;
     sv.isFixed = isFixed;
     currentScope().define(name, sv);
-    DEBUG_SCOPE_LOG("defineVar '" << name << "', dynamic=" << (isDynamic ? "true" : "false") 
+    DEBUG_SCOPE_LOG("defineVar '" << symbolName(name) << "', dynamic=" << (isDynamic ? "true" : "false") 
                     << ", fixed=" << (isFixed ? "true" : "false"));
 }
 
-void Interpreter::setVar(const std::string& name, const Value& v) {
+void Interpreter::setVar(Symbol name, const Value& v) {
     StoredVar* sv = currentScope().lookup(name);
     if (!sv) {
         defineVar(name, v, false, false);  // Nuova variabile: non dynamic, non fixed
         return;
     }
-    
+    assignStored(*sv, name, v);
+}
+
+void Interpreter::assignStored(StoredVar& sv, Symbol name, const Value& v) {
     // Controlla se è fixed
-    if (sv->isFixed) {
+    if (sv.isFixed) {
         // Messaggio specifico per variabili funzione
-        if (isType<FunctionValue>(sv->value)) {
+        if (isType<FunctionValue>(sv.value)) {
             runtimeError(nullptr, 
-                "Impossibile riassegnare variabile funzione '" + name + "'\n" +
+                "Impossibile riassegnare variabile funzione '" + symbolName(name) + "'\n" +
                 "Le funzioni sono immutabili per natura.\n" +
                 "Suggerimento: Crea una nuova variabile con un nome diverso.");
         } else {
-            runtimeError(nullptr, "Impossibile riassegnare variabile 'fixed': " + name);
+            runtimeError(nullptr, "Impossibile riassegnare variabile 'fixed': " + symbolName(name));
         }
         return;
     }
     
     // Per array, controlla se è dynamic
-    if (isType<ArrayValue>(sv->value) && !sv->isDynamic) {
-        runtimeError(nullptr, "Array '" + name + "' non è dynamic, non può essere riassegnato");
+    if (isType<ArrayValue>(sv.value) && !sv.isDynamic) {
+        runtimeError(nullptr, "Array '" + symbolName(name) + "' non è dynamic, non può essere riassegnato");
         return;
     }
     
-    sv->value = v;
+    sv.value = v;
+
+    // Array dynamic: un range assegnato diventa subito un vettore
+    if (sv.isDynamic && isType<ArrayValue>(sv.value) &&
+        as<ArrayValue>(std::as_const(sv.value)).range())
+        as<ArrayValue>(sv.value).materialize();
+}
+
+// =======================
+// Variabili risolte (slot del Resolver)
+// =======================
+
+// Slot (depth, slot) se già definito, altrimenti lookup per nome come prima
+StoredVar* Interpreter::findVar(const ASTNode& ref) {
+    if (ref.slot >= 0) {
+        Scope* s = &currentScope();
+        for (int d = 0; d < ref.depth && s; ++d) s = s->parent;
+        if (s) {
+            if (StoredVar* sv = s->slotAt(ref.slot)) return sv;
+        }
+    }
+    return currentScope().lookup(ref.sym);
+}
+
+Value Interpreter::lookupVar(const ASTNode& ref) {
+    if (ref.slot >= 0) {
+        if (StoredVar* sv = findVar(ref)) return sv->value;
+    }
+    return lookup(ref.sym);
+}
+
+void Interpreter::defineVarAt(const ASTNode& decl, const Value& v, bool isDynamic, bool isFixed) {
+    Scope& scope = currentScope();
+    if (decl.slot >= 0 && decl.depth == 0 && decl.slot < static_cast<int>(scope.slots.size())) {
+        StoredVar sv;
+        sv.value = v;
+        sv.isDynamic = isDynamic;
+        sv.isFixed = isFixed;
+        scope.defineSlot(decl.slot, sv);
+        return;
+    }
+    defineVar(decl.sym, v, isDynamic, isFixed);
+}
+
+void Interpreter::setVarAt(const ASTNode& ref, const Value& v) {
+    StoredVar* sv = findVar(ref);
+    if (!sv) {
+        defineVarAt(ref, v, false, false);  // Nuova variabile: non dynamic, non fixed
+        return;
+    }
+    assignStored(*sv, ref.sym, v);
 }
 
 // =======================
@@ -238,44 +363,40 @@ void Interpreter::setVar(const std::string& name, const Value& v) {
 
 bool Interpreter::isTruthy(const Value& v) const {
     if (isType<int>(v))
-        return as<int>(const_cast<Value&>(v)) != 0;
+        return as<int>(v) != 0;
 
     if (isType<double>(v))
-        return as<double>(const_cast<Value&>(v)) != 0.0;
+        return as<double>(v) != 0.0;
 
     if (isType<std::string>(v))
-        return !as<std::string>(const_cast<Value&>(v)).empty();
+        return !as<std::string>(v).empty();
 
     if (isType<ArrayValue>(v))
-        return !as<ArrayValue>(const_cast<Value&>(v)).empty();
+        return !as<ArrayValue>(v).empty();
 
     return false;
 }
 
 std::string Interpreter::toString(const Value& v) const {
     if (isType<int>(v))
-        return std::to_string(as<int>(const_cast<Value&>(v)));
+        return std::to_string(as<int>(v));
 
     if (isType<double>(v)) {
         std::ostringstream oss;
-        oss << as<double>(const_cast<Value&>(v));
+        oss << as<double>(v);
         return oss.str();
     }
 
     if (isType<std::string>(v))
-        return as<std::string>(const_cast<Value&>(v));
+        return as<std::string>(v);
 
     if (isType<ArrayValue>(v)) {
         std::ostringstream oss;
-        const auto& arr = as<ArrayValue>(const_cast<Value&>(v));
+        const auto& arr = as<ArrayValue>(v);
         oss << "[";
         for (size_t i = 0; i < arr.size(); ++i) {
             if (i > 0) oss << ", ";
-            if (arr[i]) {
-                oss << toString(*arr[i]);
-            } else {
-                oss << "0";
-            }
+            oss << toString(arr.get(i));
         }
         oss << "]";
         return oss.str();
@@ -287,13 +408,114 @@ std::string Interpreter::toString(const Value& v) const {
     return "0";
 }
 
+// =======================
+// Uguaglianza (== e !=)
+// =======================
+
+// Forma testuale di un int/double identica a toString(), in un buffer locale
+static const char* formatNumber(const Value& v, char* buf, size_t size) {
+    if (isType<int>(v))
+        std::snprintf(buf, size, "%d", as<int>(v));
+    else
+        std::snprintf(buf, size, "%g", as<double>(v));  // come ostream << double
+    return buf;
+}
+
+// Vero se nella forma testuale di v ogni stringa è non vuota e senza ',' '[' ']':
+// allora la forma di un array si scompone in modo univoco nei suoi elementi
+static bool plainText(const Value& v) {
+    if (isType<std::string>(v)) {
+        const std::string& s = as<std::string>(v);
+        return !s.empty() && s.find_first_of(",[]") == std::string::npos;
+    }
+    if (isType<ArrayValue>(v)) {
+        const ArrayValue& arr = as<ArrayValue>(v);
+        if (arr.ints() || arr.doubles() || arr.range()) return true;
+        if (auto strs = arr.strings()) {
+            for (const auto& s : *strs)
+                if (s.empty() || s.find_first_of(",[]") != std::string::npos) return false;
+            return true;
+        }
+        for (size_t i = 0; i < arr.size(); ++i)
+            if (!plainText(arr.get(i))) return false;
+    }
+    return true;
+}
+
+// Stessa semantica di toString(left) == toString(right) (quindi 3 == 3.0 e
+// "3" == 3), ma senza costruire le stringhe nei casi comuni
+bool Interpreter::valuesEqual(const Value& a, const Value& b) const {
+    // Stesso valore inline o stesso oggetto condiviso (copy-on-write)
+    if (a.tag == b.tag && a.bits == b.bits) return true;
+
+    if (isType<int>(a) && isType<int>(b))
+        return as<int>(a) == as<int>(b);
+
+    if (isType<std::string>(a) && isType<std::string>(b))
+        return as<std::string>(a) == as<std::string>(b);
+
+    bool numA = isType<int>(a) || isType<double>(a);
+    bool numB = isType<int>(b) || isType<double>(b);
+    char bufA[32], bufB[32];
+
+    if (numA && numB)
+        return std::strcmp(formatNumber(a, bufA, sizeof bufA),
+                           formatNumber(b, bufB, sizeof bufB)) == 0;
+
+    if (isType<ArrayValue>(a) && isType<ArrayValue>(b))
+        return arraysEqual(a, b);
+
+    if (isType<FunctionValue>(a) && isType<FunctionValue>(b))
+        return true;    // entrambe "<function>"
+
+    // Tipi diversi: solo una stringa può avere la forma testuale di un altro tipo
+    if (!isType<std::string>(a) && !isType<std::string>(b))
+        return false;
+
+    const std::string& s = as<std::string>(isType<std::string>(a) ? a : b);
+    const Value& other = isType<std::string>(a) ? b : a;
+
+    if (isType<int>(other) || isType<double>(other))
+        return s == formatNumber(other, bufA, sizeof bufA);
+    if (isType<FunctionValue>(other))
+        return s == "<function>";
+    return s == toString(other);
+}
+
+bool Interpreter::arraysEqual(const Value& a, const Value& b) const {
+    const ArrayValue& x = as<ArrayValue>(a);
+    const ArrayValue& y = as<ArrayValue>(b);
+
+    // Array di int: confronto diretto dello storage
+    if (x.ints() && y.ints())
+        return *x.ints() == *y.ints();
+
+    // Elemento per elemento, con uscita al primo diverso
+    if (x.size() == y.size()) {
+        bool same = true;
+        if (x.strings() && y.strings()) {
+            same = *x.strings() == *y.strings();
+        } else {
+            for (size_t i = 0; i < x.size() && same; ++i)
+                same = valuesEqual(x.get(i), y.get(i));
+        }
+        if (same) return true;
+    }
+
+    // Forme testuali diverse, a meno che le stringhe non le rendano ambigue
+    // (es. [""] e [] sono entrambe "[]")
+    if (plainText(a) && plainText(b)) return false;
+    return toString(a) == toString(b);
+}
+
 void Interpreter::runtimeError(const ASTNode* node, const std::string& msg) const {
+    ++errorCount;
     if (node)
-        std::cerr << "Errore (riga " << node->line
-                  << ", colonna " << node->column
-                  << "): " << msg << "\n";
+        *errors << "Errore (riga " << node->line
+                << ", colonna " << node->column
+                << "): " << msg << "\n";
     else
-        std::cerr << "Errore: " << msg << "\n";
+        *errors << "Errore: " << msg << "\n";
 }
 
 void Interpreter::printValue(const Value& v) const {
@@ -362,43 +584,31 @@ RangeInfo Interpreter::parseRangeNode(const std::shared_ptr<ASTNode>& node) {
 // ⭐ NUOVO: Slicing di stringhe UTF-8
 // =======================
 
-Value Interpreter::sliceString(const std::string& s,
+Value Interpreter::sliceString(const Value& str,
                                const RangeInfo& range,
                                const ASTNode* node)
 {
-    // 1) Decodifica UTF-8 in codepoints
-    std::vector<char32_t> cps;
-    try {
-        cps = decodeUtf8(s);
-    } catch (const Utf8Error& e) {
-        runtimeError(node, std::string("Errore UTF-8: ") + e.what());
+    // 1) Indice dei codepoint (cache della stringa)
+    const std::string& s = as<std::string>(str);
+    const Utf8Index& idx = utf8IndexOf(str);
+    if (!idx.valid) {
+        runtimeError(node, "Errore UTF-8: " + idx.error);
         return "";
     }
 
-    if (cps.empty())
+    if (idx.length == 0)
         return std::string("");
 
     // 2) Normalizzazione indici
     int start = 0, end = 0;
-    if (!normalizeRange(cps.size(), range, start, end)) {
+    if (!normalizeRange(idx.length, range, start, end)) {
         runtimeError(node, "Range non valido per slicing stringa");
         return "";
     }
 
-    // 3) Costruzione nuovo vettore
-    std::vector<char32_t> out;
-    out.reserve(end - start + 1);
-
-    for (int i = start; i <= end; ++i)
-        out.push_back(cps[i]);
-
-    // 4) Ricodifica UTF-8
-    try {
-        return encodeUtf8(out);
-    } catch (const Utf8Error& e) {
-        runtimeError(node, std::string("Errore UTF-8: ") + e.what());
-        return "";
-    }
+    // 3) Byte dei codepoint [start, end]
+    if (end < start) return std::string("");
+    return utf8Codepoints(s, idx, start, end - start + 1);
 }
 
 
@@ -421,17 +631,21 @@ Value Interpreter::sliceArray(const ArrayValue& arr,
         return ArrayValue{};
     }
 
+    // Slice di un range: resta un range
+    if (const IntRange* r = arr.range()) {
+        IntRange sub;
+        sub.start = r->at(start);
+        sub.step = r->step;
+        sub.count = static_cast<size_t>(end - start + 1);
+        return ArrayValue(sub);
+    }
+
     // nuovo array immutabile
     ArrayValue out;
-    out.elements.reserve(end - start + 1);
+    out.reserve(end - start + 1);
 
-    for (int i = start; i <= end; ++i) {
-        auto& elemPtr = arr.elements[i];
-        if (!elemPtr)
-            out.elements.push_back(std::make_shared<Value>(0));
-        else
-            out.elements.push_back(std::make_shared<Value>(*elemPtr));
-    }
+    for (int i = start; i <= end; ++i)
+        out.push_back(arr.get(i));
 
     return out;
 }
@@ -441,6 +655,19 @@ Value Interpreter::sliceArray(const ArrayValue& arr,
 
 
 
+// Lo scope globale adotta il layout del programma (slot del Resolver)
+void Interpreter::enterProgram(const ASTNode& program) {
+    if (program.frame && scopes.size() == 1)
+        scopes.front()->setLayout(program.frame.get());
+}
+
+// Body di una funzione: passa dal VM se l'engine bytecode è attivo
+Value Interpreter::runBody(const std::shared_ptr<ASTNode>& body) {
+    if (vm) return vm->run(body);
+    return eval(body);
+}
+
+
 // =======================
 // EVAL
 // =======================
@@ -448,1119 +675,635 @@ Value Interpreter::sliceArray(const ArrayValue& arr,
 Value Interpreter::eval(const std::shared_ptr<ASTNode>& node) {
     if (!node) return 0;
 
-    const std::string& t = node->type;
+    switch (node->kind) {
 
-    // -------- Literal --------
-    if (t == "Literal") {
-        if (node->tokenType == TokenType::NUMBER_INT) {
-            return std::stoi(node->value);
-        } else if (node->tokenType == TokenType::NUMBER_DBL) {
-            return std::stod(node->value);
-        } else if (node->tokenType == TokenType::STRING) {
-            return node->value;
+        // -------- Literal --------
+        case NodeKind::Literal: {
+            return node->literal;
         }
 
-        bool isNumber = !node->value.empty() &&
-                        std::all_of(node->value.begin(), node->value.end(),
-                                    [](char c){ return (c >= '0' && c <= '9'); });
-        if (isNumber) return std::stoi(node->value);
-        return node->value;
-    }
-
-    // -------- Identifier --------
-    if (t == "Identifier") {
-        return lookup(node->value);
-    }
+        // -------- Identifier --------
+        case NodeKind::Identifier: {
+            return lookupVar(*node);
+        }
 
-    // -------- Lambda --------
-    if (t == "Lambda") {
-        FunctionValue fv;
+        // -------- Lambda --------
+        case NodeKind::Lambda: {
+            FunctionValue fv;
         
-        // Estrai parametri (primi children sono Param)
-        size_t bodyIdx = 0;
-        for (size_t i = 0; i < node->children.size(); ++i) {
-            if (node->children[i]->type == "Param") {
-                fv.params.push_back(node->children[i]->value);
-            } else {
-                bodyIdx = i;
-                break;
+            // Estrai parametri (primi children sono Param)
+            size_t bodyIdx = 0;
+            for (size_t i = 0; i < node->children.size(); ++i) {
+                if (node->children[i]->kind == NodeKind::Param) {
+                    fv.params.push_back(node->children[i]->sym);
+                } else {
+                    bodyIdx = i;
+                    break;
+                }
             }
-        }
-        
-        // Body
-        if (bodyIdx < node->children.size()) {
-            fv.body = node->children[bodyIdx];
-        }
-        
-        // ============================================
-        // CATTURA CLOSURE: copia TUTTE le variabili dello scope corrente
-        // Questo permette alla lambda di accedere alle variabili
-        // anche dopo che lo scope outer è stato poppato
-        // ============================================
-        Scope& current = currentScope();
-        for (const auto& pair : current.vars) {
-            fv.capturedVars[pair.first] = pair.second.value;
-        }
         
-        // Cattura anche variabili da parent scopes
-        Scope* parent = current.parent;
-        while (parent) {
-            for (const auto& pair : parent->vars) {
-                // Non sovrascrivere se già catturata da scope più vicino
-                if (fv.capturedVars.find(pair.first) == fv.capturedVars.end()) {
-                    fv.capturedVars[pair.first] = pair.second.value;
-                }
+            // Body
+            if (bodyIdx < node->children.size()) {
+                fv.body = node->children[bodyIdx];
             }
-            parent = parent->parent;
-        }
         
-        // Closure scope (deprecato, ma lo mantengo per compatibilità)
-        fv.closureScope = &currentScope();
+            // ============================================
+            // CATTURA CLOSURE: copia le variabili libere del body
+            // (calcolate dal Resolver) visibili nello scope corrente.
+            // Questo permette alla lambda di accedere alle variabili
+            // anche dopo che lo scope outer è stato poppato
+            // ============================================
+            fv.capturedVars = captureFor(fv.body);
         
-        return fv;
-    }
-
-    // -------- IfExpr (v3.5) --------
-    if (t == "IfExpr") {
-        if (node->children.size() < 2) {
-            runtimeError(node.get(), "IfExpr malformato");
-            return 0;
+            // Closure scope (deprecato, ma lo mantengo per compatibilità)
+            fv.closureScope = &currentScope();
+        
+            return fv;
         }
+
+        // -------- IfExpr (v3.5) --------
+        case NodeKind::IfExpr: {
+            if (node->children.size() < 2) {
+                runtimeError(node.get(), "IfExpr malformato");
+                return 0;
+            }
         
-        int elifCount = 0;
-        bool hasElse = false;
+            int elifCount = 0;
+            bool hasElse = false;
         
-        if (node->extra.count("elifCount")) {
-            elifCount = std::stoi(node->extra.at("elifCount"));
-        }
-        if (node->extra.count("hasElse")) {
-            hasElse = (node->extra.at("hasElse") == "true");
-        }
+            if (node->extra.count("elifCount")) {
+                elifCount = std::stoi(node->extra.at("elifCount"));
+            }
+            if (node->extra.count("hasElse")) {
+                hasElse = (node->extra.at("hasElse") == "true");
+            }
         
-        // Eval main if condition
-        Value condValue = eval(node->children[0]);
-        if (isTruthy(condValue)) {
-            // Eval then body
-            return eval(node->children[1]);
-        }
+            // Eval main if condition
+            Value condValue = eval(node->children[0]);
+            if (isTruthy(condValue)) {
+                // Eval then body
+                return eval(node->children[1]);
+            }
         
-        // Eval elif branches
-        int childIdx = 2; // Start after condition and thenBody
-        for (int i = 0; i < elifCount; i++) {
-            if (childIdx + 1 >= node->children.size()) break;
+            // Eval elif branches
+            int childIdx = 2; // Start after condition and thenBody
+            for (int i = 0; i < elifCount; i++) {
+                if (childIdx + 1 >= node->children.size()) break;
             
-            Value elifCondValue = eval(node->children[childIdx]);
-            if (isTruthy(elifCondValue)) {
-                // Eval elif body
-                return eval(node->children[childIdx + 1]);
+                Value elifCondValue = eval(node->children[childIdx]);
+                if (isTruthy(elifCondValue)) {
+                    // Eval elif body
+                    return eval(node->children[childIdx + 1]);
+                }
+                childIdx += 2; // Skip condition + body
             }
-            childIdx += 2; // Skip condition + body
-        }
         
-        // Eval else branch if present
-        if (hasElse) {
-            int elseIdx = 2 + (elifCount * 2); // After all if/elif pairs
-            if (elseIdx < node->children.size()) {
-                return eval(node->children[elseIdx]);
+            // Eval else branch if present
+            if (hasElse) {
+                int elseIdx = 2 + (elifCount * 2); // After all if/elif pairs
+                if (elseIdx < node->children.size()) {
+                    return eval(node->children[elseIdx]);
+                }
             }
-        }
         
-        // No branch matched, return 0
-        return 0;
-    }
-
-    // -------- While --------
-    if (t == "While") {
-        if (node->children.size() < 2) {
-            runtimeError(node.get(), "While malformato");
+            // No branch matched, return 0
             return 0;
         }
+
+        // -------- While --------
+        case NodeKind::While: {
+            if (node->children.size() < 2) {
+                runtimeError(node.get(), "While malformato");
+                return 0;
+            }
         
-        auto condNode = node->children[0];
-        auto bodyNode = node->children[1];
+            auto condNode = node->children[0];
+            auto bodyNode = node->children[1];
         
-        // Variabile di return (opzionale)
-        std::string returnVar = node->extra.count("returnVar") 
-                              ? node->extra.at("returnVar") 
-                              : "";
+            // Variabile di return (opzionale)
+            Symbol returnVar = node->returnVar;
         
-        Value lastVal = 0;
+            Value lastVal = 0;
         
-        while (isTruthy(eval(condNode))) {
-            eval(bodyNode);
+            while (isTruthy(eval(condNode))) {
+                eval(bodyNode);
             
-            // Se c'è returnVar, leggi il suo valore
-            if (!returnVar.empty()) {
-                lastVal = lookup(returnVar);
+                // Se c'è returnVar, leggi il suo valore
+                if (returnVar != NO_SYMBOL) {
+                    lastVal = lookup(returnVar);
+                }
             }
-        }
         
-        return returnVar.empty() ? 0 : lastVal;
-    }
-
-    // -------- ForIn --------
-    if (t == "ForIn") {
-        if (node->children.size() < 2) {
-            runtimeError(node.get(), "ForIn malformato");
-            return 0;
+            return returnVar == NO_SYMBOL ? 0 : lastVal;
         }
+
+        // -------- ForIn --------
+        case NodeKind::ForIn: {
+            if (node->children.size() < 2) {
+                runtimeError(node.get(), "ForIn malformato");
+                return 0;
+            }
         
-        std::string iterVar = node->value;
-        auto collectionNode = node->children[0];
-        auto bodyNode = node->children[1];
+            auto collectionNode = node->children[0];
+            auto bodyNode = node->children[1];
         
-        // Variabile di return (opzionale)
-        std::string returnVar = node->extra.count("returnVar") 
-                              ? node->extra.at("returnVar") 
-                              : "";
+            // Variabile di return (opzionale)
+            Symbol returnVar = node->returnVar;
         
-        Value collection = eval(collectionNode);
+            // Snapshot della collezione: copiare il Value costa solo un
+            // incremento del refcount, e le modifiche fatte dal body
+            // (copy-on-write) non toccano gli elementi visitati
+            Value collection = eval(collectionNode);
         
-        if (!isType<ArrayValue>(collection)) {
-            runtimeError(node.get(), "for-in richiede un array");
-            return 0;
-        }
+            if (!isType<ArrayValue>(collection)) {
+                runtimeError(node.get(), "for-in richiede un array");
+                return 0;
+            }
         
-        auto& arr = as<ArrayValue>(collection);
-        Value lastVal = 0;
+            Value lastVal = 0;
         
-        for (auto& elem : arr.elements) {
-            // Definisci variabile iteratore
-            defineVar(iterVar, *elem, false, false);
+            const auto& arr = as<ArrayValue>(std::as_const(collection));
+            size_t count = arr.size();
+            for (size_t i = 0; i < count; ++i) {
+                Value elem = arr.get(i);
+
+                // Definisci variabile iteratore
+                defineVarAt(*node, elem, false, false);
             
-            eval(bodyNode);
+                eval(bodyNode);
             
-            // Se c'è returnVar, leggi il suo valore
-            if (!returnVar.empty()) {
-                lastVal = lookup(returnVar);
+                // Se c'è returnVar, leggi il suo valore
+                if (returnVar != NO_SYMBOL) {
+                    lastVal = lookup(returnVar);
+                }
             }
-        }
         
-        return returnVar.empty() ? 0 : lastVal;
-    }
+            return returnVar == NO_SYMBOL ? 0 : lastVal;
+        }
 
-    // -------- CommaList --------
-    if (t == "CommaList") {
-        Value last = 0;
-        for (auto& ch : node->children) last = eval(ch);
-        return last;
-    }
+        // -------- CommaList --------
+        case NodeKind::CommaList: {
+            Value last = 0;
+            for (auto& ch : node->children) last = eval(ch);
+            return last;
+        }
 
-    // -------- Assign (nuovo) --------
-    if (t == "Assign") {
-        return evalAssignment(node);
-    }
+        // -------- Assign (nuovo) --------
+        case NodeKind::Assign: {
+            return evalAssignment(node);
+        }
 
-   // -------- BinaryOp / LogicalOp --------
-    if (t == "BinaryOp" || t == "LogicalOp") {
+        // -------- BinaryOp / LogicalOp --------
+        case NodeKind::BinaryOp:
+        case NodeKind::LogicalOp: {
 
-        // ⭐ Caso speciale: "$" con RangeExpr a destra
-        if (t == "BinaryOp" &&
-            node->value == "$" &&
-            node->children.size() == 2 &&
-            node->children[1] &&
-            node->children[1]->type == "RangeExpr")
-        {
-            // 1) valuta solo il left
-            Value leftVal = eval(node->children[0]);
+            // ⭐ Caso speciale: "$" con RangeExpr a destra
+            if (node->kind == NodeKind::BinaryOp &&
+                node->op == Operator::Concat &&
+                node->children.size() == 2 &&
+                node->children[1] &&
+                node->children[1]->kind == NodeKind::RangeExpr)
+            {
+                // 1) valuta solo il left
+                const Value leftVal = eval(node->children[0]);
 
-            // 2) parsa il range dalla AST (usa già eval per start/end)
-            RangeInfo range = parseRangeNode(node->children[1]);
+                // 2) parsa il range dalla AST (usa già eval per start/end)
+                RangeInfo range = parseRangeNode(node->children[1]);
 
-            // 2b) VALIDAZIONE PRE-SLICE (Opzione A: abort on invalid)
-            // per stringhe: dobbiamo conoscere la lunghezza in codepoints
-            if (isType<std::string>(leftVal)) {
-                try {
-                    auto cps = decodeUtf8(as<std::string>(leftVal));
+                // 2b) VALIDAZIONE PRE-SLICE (Opzione A: abort on invalid)
+                // per stringhe: dobbiamo conoscere la lunghezza in codepoints
+                if (isType<std::string>(leftVal)) {
+                    const Utf8Index& idx = utf8IndexOf(leftVal);
+                    if (!idx.valid) {
+                        runtimeError(node.get(), "Errore UTF-8: " + idx.error);
+                        return 0;
+                    }
                     int start, end;
-                    if (!normalizeRange(cps.size(), range, start, end)) {
+                    if (!normalizeRange(idx.length, range, start, end)) {
                         runtimeError(node.get(), "Range invalido per stringa durante concatenazione '$' (abort)");
                         return 0;
                     }
-                } catch (const Utf8Error& e) {
-                    runtimeError(node.get(), std::string("Errore UTF-8: ") + e.what());
-                    return 0;
                 }
-            }
-            // per array: lunghezza elementi
-            else if (isType<ArrayValue>(leftVal)) {
-                auto& arr = as<ArrayValue>(leftVal);
-                int start, end;
-                if (!normalizeRange(arr.size(), range, start, end)) {
-                    runtimeError(node.get(), "Range invalido per array durante concatenazione '$' (abort)");
+                // per array: lunghezza elementi
+                else if (isType<ArrayValue>(leftVal)) {
+                    auto& arr = as<ArrayValue>(leftVal);
+                    int start, end;
+                    if (!normalizeRange(arr.size(), range, start, end)) {
+                        runtimeError(node.get(), "Range invalido per array durante concatenazione '$' (abort)");
+                        return 0;
+                    }
+                }
+                else {
+                    runtimeError(node.get(),
+                        "Range dopo '$' supportato solo su stringhe e array");
                     return 0;
                 }
-            }
-            else {
-                runtimeError(node.get(),
-                    "Range dopo '$' supportato solo su stringhe e array");
-                return 0;
-            }
 
-            // 3) applica lo slice SU left (sliceString/sliceArray ritornano Value)
-            Value rightVal;
-            if (isType<std::string>(leftVal)) {
-                rightVal = sliceString(as<std::string>(leftVal), range, node.get());
-                // sliceString segnalerà errori con runtimeError; per Opzione A abbiamo già validato
-            } else { // array
-                rightVal = sliceArray(as<ArrayValue>(leftVal), range, node.get());
+                // 3) applica lo slice SU left (sliceString/sliceArray ritornano Value)
+                Value rightVal;
+                if (isType<std::string>(leftVal)) {
+                    rightVal = sliceString(leftVal, range, node.get());
+                    // sliceString segnalerà errori con runtimeError; per Opzione A abbiamo già validato
+                } else { // array
+                    rightVal = sliceArray(as<ArrayValue>(leftVal), range, node.get());
+                }
+
+                // 4) esegui normalmente l'operatore "$" sui due valori
+                return evalBinaryOp(node->op, leftVal, rightVal, node.get());
             }
 
-            // 4) esegui normalmente l'operatore "$" sui due valori
-            return evalBinaryOp(node->value, leftVal, rightVal, node.get());
+            // caso normale per tutti gli altri operatori
+            Value left  = eval(node->children[0]);
+            Value right = eval(node->children[1]);
+            return evalBinaryOp(node->op, left, right, node.get());
         }
 
-        // caso normale per tutti gli altri operatori
-        Value left  = eval(node->children[0]);
-        Value right = eval(node->children[1]);
-        return evalBinaryOp(node->value, left, right, node.get());
-    }
-
 
-    // -------- UnaryOp --------
-    if (t == "UnaryOp") {
-        Value v = eval(node->children[0]);
-        return evalUnaryOp(node->value, v, node.get());
-    }
-
-    // -------- CondChain --------
-    if (t == "CondChain") {
-        return evalCondChain(node);
-    }
+        // -------- UnaryOp --------
+        case NodeKind::UnaryOp: {
+            Value v = eval(node->children[0]);
+            return evalUnaryOp(node->op, v, node.get());
+        }
 
-    // -------- SimpleCond --------
-    // SimpleCond viene usato dentro CondChain, ma può anche apparire standalone
-    // in alcune situazioni di parsing multi-line
-    if (t == "SimpleCond") {
-        // SimpleCond ha 2 figli:
-        // [0] = condizione
-        // [1] = espressione se vera
-        if (node->children.size() < 2) {
-            runtimeError(node.get(), "SimpleCond richiede 2 figli (condizione, espressione)");
-            return 0;
+        // -------- CondChain --------
+        case NodeKind::CondChain: {
+            return evalCondChain(node);
         }
+
+        // -------- SimpleCond --------
+        // SimpleCond viene usato dentro CondChain, ma può anche apparire standalone
+        // in alcune situazioni di parsing multi-line
+        case NodeKind::SimpleCond: {
+            // SimpleCond ha 2 figli:
+            // [0] = condizione
+            // [1] = espressione se vera
+            if (node->children.size() < 2) {
+                runtimeError(node.get(), "SimpleCond richiede 2 figli (condizione, espressione)");
+                return 0;
+            }
         
-        Value condVal = eval(node->children[0]);
-        if (isTruthy(condVal)) {
-            return eval(node->children[1]);
+            Value condVal = eval(node->children[0]);
+            if (isTruthy(condVal)) {
+                return eval(node->children[1]);
+            }
+            // Se falso, restituisce 0 (o potrebbe essere un errore)
+            return 0;
         }
-        // Se falso, restituisce 0 (o potrebbe essere un errore)
-        return 0;
-    }
 
-    if (t == "Elvis") {
-        return evalElvis(node);
-    }
+        case NodeKind::Elvis: {
+            return evalElvis(node);
+        }
 
-    if (t == "Filter") {
-        return evalFilter(node);
-    }
+        case NodeKind::Filter: {
+            return evalFilter(node);
+        }
 
-    // -------- ArrayAccess --------
-    if (t == "ArrayAccess") {
-        Value arrayVal;
-        size_t idxNodePos = 0;
+        // -------- ArrayAccess --------
+        case NodeKind::ArrayAccess: {
+            // Snapshot dell'array (copia del Value, O(1)): l'indice o il
+            // range sono valutati dopo e possono modificare la variabile
+            Value snapshot;
+            size_t idxNodePos = 0;
         
-        // ============================================
-        // Nuovo formato: expr[index]
-        // value="" e children=[expr, index]
-        // ============================================
-        if (node->value.empty() && !node->children.empty()) {
-            // Evalua espressione left
-            arrayVal = eval(node->children[0]);
-            idxNodePos = 1;
-        } 
-        // ============================================
-        // Old formato: varname[index]
-        // value="varname" e children=[index]
-        // ============================================
-        else {
-            std::string name = node->value;
-            StoredVar* sv = currentScope().lookup(name);
-            if (!sv) {
-                runtimeError(node.get(), "Variabile '" + name + "' non definita");
-                return 0;
+            // ============================================
+            // Nuovo formato: expr[index]
+            // value="" e children=[expr, index]
+            // ============================================
+            if (node->value.empty() && !node->children.empty()) {
+                // Evalua espressione left
+                snapshot = eval(node->children[0]);
+                idxNodePos = 1;
+            } 
+            // ============================================
+            // Old formato: varname[index]
+            // value="varname" e children=[index]
+            // ============================================
+            else {
+                const std::string& name = node->value;
+                StoredVar* sv = findVar(*node);
+                if (!sv) {
+                    runtimeError(node.get(), "Variabile '" + name + "' non definita");
+                    return 0;
+                }
+                snapshot = sv->value;
+                idxNodePos = 0;
             }
-            arrayVal = sv->value;
-            idxNodePos = 0;
-        }
+            const Value& arrayVal = snapshot;
         
-        auto idxNode = node->children[idxNodePos];
+            auto idxNode = node->children[idxNodePos];
 
-        // Range
-        if (idxNode->type == "RangeExpr") {
-            RangeInfo range = parseRangeNode(idxNode);
+            // Range
+            if (idxNode->kind == NodeKind::RangeExpr) {
+                RangeInfo range = parseRangeNode(idxNode);
 
-            // String slice
-            if (isType<std::string>(arrayVal)) {
-                try {
-                    auto cps = decodeUtf8(as<std::string>(arrayVal));
+                // String slice
+                if (isType<std::string>(arrayVal)) {
+                    const Utf8Index& idx = utf8IndexOf(arrayVal);
+                    if (!idx.valid) {
+                        runtimeError(node.get(), "Errore UTF-8: " + idx.error);
+                        return 0;
+                    }
                     int start, end;
-                    if (!normalizeRange(cps.size(), range, start, end)) {
+                    if (!normalizeRange(idx.length, range, start, end)) {
                         runtimeError(node.get(), "Range invalido per stringa (abort)");
                         return 0;
                     }
-                } catch (const Utf8Error& e) {
-                    runtimeError(node.get(), std::string("Errore UTF-8: ") + e.what());
-                    return 0;
+                    return sliceString(arrayVal, range, node.get());
                 }
-                return sliceString(as<std::string>(arrayVal), range, node.get());
-            }
 
-            // Array slice
-            if (isType<ArrayValue>(arrayVal)) {
-                auto& arr = as<ArrayValue>(arrayVal);
-                int start, end;
-                if (!normalizeRange(arr.size(), range, start, end)) {
-                    runtimeError(node.get(), "Range invalido per array (abort)");
-                    return 0;
+                // Array slice
+                if (isType<ArrayValue>(arrayVal)) {
+                    auto& arr = as<ArrayValue>(arrayVal);
+                    int start, end;
+                    if (!normalizeRange(arr.size(), range, start, end)) {
+                        runtimeError(node.get(), "Range invalido per array (abort)");
+                        return 0;
+                    }
+                    return sliceArray(as<ArrayValue>(arrayVal), range, node.get());
                 }
-                return sliceArray(as<ArrayValue>(arrayVal), range, node.get());
+
+                runtimeError(node.get(), "Slicing supportato solo su stringhe e array");
+                return 0;
             }
 
-            runtimeError(node.get(), "Slicing supportato solo su stringhe e array");
-            return 0;
+            // Indice singolo
+            return indexValue(arrayVal, eval(idxNode), node.get());
         }
 
-        // Indice singolo
-        Value idxV = eval(idxNode);
-        if (!isType<int>(idxV)) {
-            runtimeError(node.get(), "Indice deve essere int");
+        // -------- RangeExpr standalone --------
+        case NodeKind::RangeExpr: {
+            runtimeError(node.get(), "Range non può essere valutato direttamente (serve un target)");
             return 0;
         }
-        int idx = as<int>(idxV);
 
-        // Stringa → singolo carattere
-        if (isType<std::string>(arrayVal)) {
-            try {
-                auto codepoints = decodeUtf8(as<std::string>(arrayVal));
-                int normIdx = normalizeIndex(idx, codepoints.size());
-                if (normIdx < 0) {
-                    runtimeError(node.get(), "Indice stringa fuori limite");
-                    return "";
-                }
-                return encodeUtf8({codepoints[normIdx]});
-            } catch (const Utf8Error& e) {
-                runtimeError(node.get(), std::string("Errore UTF-8: ") + e.what());
-                return "";
-            }
-        }
+        // -------- Call --------
+        case NodeKind::Call: {
+            // Destinazione risolta prima degli argomenti (prepareCall),
+            // gli stessi passi del VM
+            PreparedCall call = prepareCall(*node);
+            if (call.kind == PreparedCall::Kind::Done)
+                return std::move(call.value);
 
-        // Array
-        if (isType<ArrayValue>(arrayVal)) {
-            auto& arr = as<ArrayValue>(arrayVal);
-            int normIdx = normalizeIndex(idx, arr.size());
-            if (normIdx < 0) {
-                runtimeError(node.get(), "Indice array fuori limite");
-                return 0;
-            }
-            if (!arr[(size_t)normIdx]) return 0;
-            return *arr[(size_t)normIdx];
-        }
-
-        runtimeError(node.get(), "Valore non indicizzabile (richiesto array o stringa)");
-        return 0;
-    }
-
-    // -------- RangeExpr standalone --------
-    if (t == "RangeExpr") {
-        runtimeError(node.get(), "Range non può essere valutato direttamente (serve un target)");
-        return 0;
-    }
-
-    // -------- Call --------
-    if (t == "Call") {
-        std::string fname = node->value;
-        
-        // ============================================
-        // FIRST-CLASS FUNCTION CALL
-        // Usa Interpreter::lookup() che cerca:
-        // 1. Variabili (incluse quelle con FunctionValue)
-        // 2. Funzioni locali (nested)
-        // 3. Funzioni globali (def top-level) ← NUOVO v3.5.1!
-        // ============================================
-        Value fnameValue = lookup(fname);  // ← Usa Interpreter::lookup()!
-        
-        if (isType<FunctionValue>(fnameValue)) {
-            auto& fv = as<FunctionValue>(fnameValue);
-            
-            // Valuta argomenti
-            ArrayValue args;
+            std::vector<Value> args;
+            args.reserve(node->children.size());
             for (auto& ch : node->children)
-                args.push_back(std::make_shared<Value>(eval(ch)));
-            
-            // Controlla numero argomenti
-            if (args.size() != fv.params.size()) {
-                runtimeError(node.get(), "Numero argomenti errato per funzione first-class");
-                return 0;
-            }
-            
-            // ============================================
-            // FUNZIONE COMPOSTA: f $ g
-            // ============================================
-            if (!fv.composedFuncs.empty()) {
-                // Esegui composizione: (f $ g)(x) = g(f(x))
-                Value result = *args[0];  // Valore iniziale
-                
-                // Applica ogni funzione in sequenza
-                for (auto& funcPtr : fv.composedFuncs) {
-                    const FunctionValue& func = *funcPtr;
-                    
-                    // Crea scope temporaneo
-                    pushScope();
-                    
-                    // Ripristina variabili catturate
-                    for (const auto& pair : func.capturedVars) {
-                        defineVar(pair.first, pair.second, false, false);
-                    }
-                    
-                    // Bind parametro
-                    defineVar(func.params[0], result, false, false);
-                    
-                    // Esegui funzione
-                    result = eval(func.body);
-                    
-                    popScope();
-                }
-                
-                return result;
-            }
-            
-            // ============================================
-            // FUNZIONE NORMALE
-            // ============================================
-            
-            // Crea nuovo scope
-            pushScope();
-            
-            // ============================================
-            // RIPRISTINA VARIABILI CATTURATE (closure)
-            // Questo permette alla funzione di accedere alle variabili
-            // dello scope in cui è stata definita
-            // ============================================
-            for (const auto& pair : fv.capturedVars) {
-                defineVar(pair.first, pair.second, false, false);
-            }
-            
-            // Bind parametri (possono sovrascrivere variabili catturate)
-            for (size_t i = 0; i < fv.params.size(); ++i) {
-                defineVar(fv.params[i], *args[i], false, false);
-            }
-            
-            // Esegui body
-            Value ret = eval(fv.body);
-            
-            popScope();
-            
-            return ret;
+                args.push_back(eval(ch));
+
+            return finishCall(call, std::move(args), *node);
         }
-        
+
         // ============================================
-        // BUILT-IN FUNCTIONS
+        // CALLEXPR: Chiamata su espressione
+        // Es: (doubler $ addFive)(10)
         // ============================================
-        
-        // --- str() ---
-        if (fname == "str") {
-            if (node->children.size() != 1) {
-                runtimeError(node.get(), "str() richiede esattamente 1 argomento");
-                return "";
-            }
-            Value arg = eval(node->children[0]);
-            return toString(arg);
-        }
-        
-        // --- len() ---
-        if (fname == "len") {
-            if (node->children.size() != 1) {
-                runtimeError(node.get(), "len() richiede esattamente 1 argomento");
+        case NodeKind::CallExpr: {
+            // Primo child è l'espressione da chiamare
+            auto funcExpr = node->children[0];
+            Value funcVal = eval(funcExpr);
+        
+            if (!isType<FunctionValue>(funcVal)) {
+                runtimeError(node.get(), 
+                    "CallExpr: l'espressione non valuta a una funzione");
                 return 0;
             }
-            Value arg = eval(node->children[0]);
-            if (isType<std::string>(arg)) {
-                return static_cast<int>(decodeUtf8(as<std::string>(arg)).size());
-            }
-            if (isType<ArrayValue>(arg)) {
-                return static_cast<int>(as<ArrayValue>(arg).size());
-            }
-            runtimeError(node.get(), "len() supporta solo string e array");
-            return 0;
-        }
         
-        // --- randInt(min, max) → int in [min, max) ---
-        if (fname == "randInt") {
-            if (node->children.size() != 2) {
-                runtimeError(node.get(), "randInt() richiede 2 argomenti (min, max)");
-                return 0;
-            }
-            Value minVal = eval(node->children[0]);
-            Value maxVal = eval(node->children[1]);
-            
-            if (!isType<int>(minVal) || !isType<int>(maxVal)) {
-                runtimeError(node.get(), "randInt(): argomenti devono essere int");
-                return 0;
-            }
-            
-            int min = as<int>(minVal);
-            int max = as<int>(maxVal);
-            
-            if (min >= max) {
-                runtimeError(node.get(), "randInt(): min deve essere < max");
-                return 0;
-            }
-            
-            // Generate random int in [min, max)
-            static bool seeded = false;
-            if (!seeded) {
-                std::srand(static_cast<unsigned>(std::time(nullptr)));
-                seeded = true;
-            }
-            
-            int range = max - min;
-            int randomInt = min + (std::rand() % range);
-            return randomInt;
-        }
+            auto& fv = as<FunctionValue>(funcVal);
         
-        // --- randDouble() → double in [0.0, 1.0) ---
-        if (fname == "randDouble") {
-            if (node->children.size() != 0) {
-                runtimeError(node.get(), "randDouble() non accetta argomenti");
-                return 0;
+            // Valuta argomenti (dal secondo child in poi)
+            std::vector<Value> args;
+            for (size_t i = 1; i < node->children.size(); ++i) {
+                args.push_back(eval(node->children[i]));
             }
-            
-            // Generate random double in [0.0, 1.0)
-            static bool seeded = false;
-            if (!seeded) {
-                std::srand(static_cast<unsigned>(std::time(nullptr)));
-                seeded = true;
-            }
-            
-            double randomDouble = static_cast<double>(std::rand()) / RAND_MAX;
-            return randomDouble;
-        }
         
-        // --- array_push() ---
-        if (fname == "array_push") {
-            if (node->children.size() != 2) {
-                runtimeError(node.get(), "array_push() richiede 2 argomenti (array, value)");
-                return 0;
-            }
-            
-            // Primo arg deve essere identifier (nome array)
-            if (node->children[0]->type != "Identifier") {
-                runtimeError(node.get(), "array_push(): primo argomento deve essere nome array");
-                return 0;
-            }
-            
-            std::string arrName = node->children[0]->value;
-            auto sv = currentScope().lookup(arrName);
-            if (!sv) {
-                runtimeError(node.get(), "Array '" + arrName + "' non definito");
-                return 0;
-            }
-            
-            if (!isType<ArrayValue>(sv->value)) {
-                runtimeError(node.get(), "'" + arrName + "' non è un array");
-                return 0;
-            }
-            
-            if (!sv->isDynamic) {
-                runtimeError(node.get(), "Array '" + arrName + "' non è dynamic");
-                return 0;
-            }
-            
-            Value newVal = eval(node->children[1]);
-            as<ArrayValue>(sv->value).push_back(std::make_shared<Value>(newVal));
-            return 0;
-        }
-        
-        // --- array_pop() ---
-        if (fname == "array_pop") {
-            if (node->children.size() != 1) {
-                runtimeError(node.get(), "array_pop() richiede 1 argomento (array)");
-                return 0;
-            }
-            
-            if (node->children[0]->type != "Identifier") {
-                runtimeError(node.get(), "array_pop(): argomento deve essere nome array");
-                return 0;
-            }
-            
-            std::string arrName = node->children[0]->value;
-            auto sv = currentScope().lookup(arrName);
-            if (!sv) {
-                runtimeError(node.get(), "Array '" + arrName + "' non definito");
-                return 0;
-            }
-            
-            if (!isType<ArrayValue>(sv->value)) {
-                runtimeError(node.get(), "'" + arrName + "' non è un array");
-                return 0;
-            }
-            
-            if (!sv->isDynamic) {
-                runtimeError(node.get(), "Array '" + arrName + "' non è dynamic");
-                return 0;
-            }
-            
-            auto& arr = as<ArrayValue>(sv->value);
-            if (arr.empty()) {
-                runtimeError(node.get(), "array_pop(): array vuoto");
-                return 0;
-            }
-            
-            Value ret = *arr.elements.back();
-            arr.elements.pop_back();
-            return ret;
-        }
-        
-        // --- array_length() ---
-        if (fname == "array_length") {
-            if (node->children.size() != 1) {
-                runtimeError(node.get(), "array_length() richiede 1 argomento");
-                return 0;
-            }
-            Value arg = eval(node->children[0]);
-            if (!isType<ArrayValue>(arg)) {
-                runtimeError(node.get(), "array_length() supporta solo array");
-                return 0;
-            }
-            return static_cast<int>(as<ArrayValue>(arg).size());
-        }
-        
-        // --- array_first() ---
-        if (fname == "array_first") {
-            if (node->children.size() != 1) {
-                runtimeError(node.get(), "array_first() richiede 1 argomento");
-                return 0;
-            }
-            Value arg = eval(node->children[0]);
-            if (!isType<ArrayValue>(arg)) {
-                runtimeError(node.get(), "array_first() supporta solo array");
-                return 0;
-            }
-            auto& arr = as<ArrayValue>(arg);
-            if (arr.empty()) {
-                runtimeError(node.get(), "array_first(): array vuoto");
-                return 0;
-            }
-            return *arr.elements[0];
-        }
-        
-        // --- array_last() ---
-        if (fname == "array_last") {
-            if (node->children.size() != 1) {
-                runtimeError(node.get(), "array_last() richiede 1 argomento");
-                return 0;
-            }
-            Value arg = eval(node->children[0]);
-            if (!isType<ArrayValue>(arg)) {
-                runtimeError(node.get(), "array_last() supporta solo array");
-                return 0;
-            }
-            auto& arr = as<ArrayValue>(arg);
-            if (arr.empty()) {
-                runtimeError(node.get(), "array_last(): array vuoto");
-                return 0;
-            }
-            return *arr.elements.back();
-        }
-        
-        // --- toInt() ---
-        if (fname == "toInt") {
-            if (node->children.size() != 1) {
-                runtimeError(node.get(), "toInt() richiede 1 argomento");
+            // Controlla numero argomenti
+            if (args.size() != fv.params.size()) {
+                runtimeError(node.get(), 
+                    "CallExpr: numero argomenti errato (attesi " + 
+                    std::to_string(fv.params.size()) + ", trovati " + 
+                    std::to_string(args.size()) + ")");
                 return 0;
             }
-            Value arg = eval(node->children[0]);
-            if (isType<int>(arg)) return arg;
-            if (isType<double>(arg)) return static_cast<int>(as<double>(arg));
-            if (isType<std::string>(arg)) {
-                try {
-                    return std::stoi(as<std::string>(arg));
-                } catch (...) {
-                    runtimeError(node.get(), "toInt(): conversione fallita");
-                    return 0;
-                }
-            }
-            runtimeError(node.get(), "toInt() non supporta questo tipo");
-            return 0;
-        }
-        
-        // --- toDouble() ---
-        if (fname == "toDouble") {
-            if (node->children.size() != 1) {
-                runtimeError(node.get(), "toDouble() richiede 1 argomento");
-                return 0.0;
-            }
-            Value arg = eval(node->children[0]);
-            if (isType<double>(arg)) return arg;
-            if (isType<int>(arg)) return static_cast<double>(as<int>(arg));
-            if (isType<std::string>(arg)) {
-                try {
-                    return std::stod(as<std::string>(arg));
-                } catch (...) {
-                    runtimeError(node.get(), "toDouble(): conversione fallita");
-                    return 0.0;
-                }
-            }
-            runtimeError(node.get(), "toDouble() non supporta questo tipo");
-            return 0.0;
-        }
         
-        // --- typeOf() ---
-        if (fname == "typeOf") {
-            if (node->children.size() != 1) {
-                runtimeError(node.get(), "typeOf() richiede 1 argomento");
-                return "";
-            }
-            Value arg = eval(node->children[0]);
-            return typeOfValue(arg);
+            return callFunctionValue(funcVal, std::move(args), node.get());
         }
-        
-        // --- input() ---
-        if (fname == "input") {
-            std::string line;
-            std::getline(std::cin, line);
-            return line;
+
+
+
+        // -------- Program --------
+        case NodeKind::Program: {
+            enterProgram(*node);
+            Value last = 0;
+            for (auto& st : node->children)
+                last = eval(st);
+            return last;
         }
-        
-        // --- range() ---
-        if (fname == "range") {
-            int start = 0, end = 0, step = 1;
-            
-            if (node->children.size() == 1) {
-                // range(end)
-                Value endVal = eval(node->children[0]);
-                if (!isType<int>(endVal)) {
-                    runtimeError(node.get(), "range(): argomento deve essere int");
-                    return ArrayValue{};
-                }
-                end = as<int>(endVal);
-            } else if (node->children.size() == 2) {
-                // range(start, end)
-                Value startVal = eval(node->children[0]);
-                Value endVal = eval(node->children[1]);
-                if (!isType<int>(startVal) || !isType<int>(endVal)) {
-                    runtimeError(node.get(), "range(): argomenti devono essere int");
-                    return ArrayValue{};
-                }
-                start = as<int>(startVal);
-                end = as<int>(endVal);
-            } else if (node->children.size() == 3) {
-                // range(start, end, step)
-                Value startVal = eval(node->children[0]);
-                Value endVal = eval(node->children[1]);
-                Value stepVal = eval(node->children[2]);
-                if (!isType<int>(startVal) || !isType<int>(endVal) || !isType<int>(stepVal)) {
-                    runtimeError(node.get(), "range(): argomenti devono essere int");
-                    return ArrayValue{};
-                }
-                start = as<int>(startVal);
-                end = as<int>(endVal);
-                step = as<int>(stepVal);
-                
-                if (step == 0) {
-                    runtimeError(node.get(), "range(): step non può essere 0");
-                    return ArrayValue{};
-                }
-            } else {
-                runtimeError(node.get(), "range(): richiede 1, 2 o 3 argomenti");
-                return ArrayValue{};
-            }
-            
-            ArrayValue result;
-            
-            if (step > 0) {
-                for (int i = start; i < end; i += step) {
-                    result.push_back(std::make_shared<Value>(i));
-                }
-            } else {
-                for (int i = start; i > end; i += step) {
-                    result.push_back(std::make_shared<Value>(i));
-                }
+
+
+        // -------- Body --------
+        case NodeKind::Body: {
+            Value last = 0;
+
+            for (auto& st : node->children) {
+                if (!st) continue;
+                execStatement(st, last);
             }
-            
-            return result;
-        }
-        
-        // ============================================
-        // USER FUNCTIONS (local + global)
-        // ============================================
-        
-        // Prima cerca in funzioni locali (nested)
-        auto localFunc = currentScope().lookupLocalFunction(fname);
-        if (localFunc) {
-            ArrayValue args;
-            for (auto& ch : node->children)
-                args.push_back(std::make_shared<Value>(eval(ch)));
-            
-            return callUserFunction(localFunc, args, node.get());
-        }
-        
-        // Poi cerca in funzioni globali
-        auto it = functions.find(fname);
-        if (it == functions.end()) {
-            runtimeError(node.get(), "Funzione '" + fname + "' non definita");
-            return 0;
-        }
 
-        ArrayValue args;
-        for (auto& ch : node->children)
-            args.push_back(std::make_shared<Value>(eval(ch)));
+            return last;
+        }
 
-        return callUserFunction(it->second, args, node.get());
+        default:
+            break;
     }
 
-    // ============================================
-    // CALLEXPR: Chiamata su espressione
-    // Es: (doubler $ addFive)(10)
-    // ============================================
-    if (t == "CallExpr") {
-        // Primo child è l'espressione da chiamare
-        auto funcExpr = node->children[0];
-        Value funcVal = eval(funcExpr);
-        
-        if (!isType<FunctionValue>(funcVal)) {
-            runtimeError(node.get(), 
-                "CallExpr: l'espressione non valuta a una funzione");
-            return 0;
+    runtimeError(node.get(), "Nodo non gestito in eval(): " + node->type);
+    return 0;
+}
+
+
+// =======================
+// Statement di un Body
+// =======================
+
+// Esegue un singolo statement di Body; 'last' è il valore corrente del Body
+// (aggiornato solo dagli statement che producono un valore)
+void Interpreter::execStatement(const std::shared_ptr<ASTNode>& st, Value& last) {
+    switch (st->kind) {
+
+        // --- Expression statement ---
+        case NodeKind::ExprStmt: {
+            last = Value();
+            last = eval(st->children[0]);
+            return;
         }
-        
-        auto& fv = as<FunctionValue>(funcVal);
-        
-        // Valuta argomenti (dal secondo child in poi)
-        ArrayValue args;
-        for (size_t i = 1; i < node->children.size(); ++i) {
-            args.push_back(std::make_shared<Value>(eval(node->children[i])));
+
+        // --- Echo ---
+        case NodeKind::Echo: {
+            Value v = eval(st->children[0]);
+            printValue(v);
+            std::cout << "\n";
+            last = v;
+            return;
         }
-        
-        // Controlla numero argomenti
-        if (args.size() != fv.params.size()) {
-            runtimeError(node.get(), 
-                "CallExpr: numero argomenti errato (attesi " + 
-                std::to_string(fv.params.size()) + ", trovati " + 
-                std::to_string(args.size()) + ")");
-            return 0;
+
+        // --- Assign ---
+        case NodeKind::Assign: {
+            last = Value();     // non trattiene la stringa che l'append estende
+            last = evalAssignment(st);
+            return;
         }
-        
-        // ============================================
-        // FUNZIONE COMPOSTA: f $ g
-        // ============================================
-        if (!fv.composedFuncs.empty()) {
-            // Esegui composizione: (f $ g)(x) = g(f(x))
-            Value result = *args[0];  // Valore iniziale
-            
-            // Applica ogni funzione in sequenza
-            for (auto& funcPtr : fv.composedFuncs) {
-                const FunctionValue& func = *funcPtr;
-                
-                // Crea scope temporaneo
-                pushScope();
-                
-                // Ripristina variabili catturate
-                for (const auto& pair : func.capturedVars) {
-                    defineVar(pair.first, pair.second, false, false);
-                }
-                
-                // Bind parametro
-                defineVar(func.params[0], result, false, false);
-                
-                // Esegui funzione
-                result = eval(func.body);
-                
-                popScope();
-            }
-            
-            return result;
+
+        // --- VarDecl ---
+        case NodeKind::VarDecl: {
+            bool isDynamic = (st->extra.count("dynamic") &&
+                              st->extra.at("dynamic") == "true");
+            bool isFixed = (st->extra.count("fixed") &&
+                            st->extra.at("fixed") == "true");
+            Value val = 0;
+            if (!st->children.empty())
+                val = eval(st->children[0]);
+            defineVarAt(*st, val, isDynamic, isFixed);
+            return;
         }
-        
+
         // ============================================
-        // FUNZIONE NORMALE
+        // --- NESTED FUNCTION DEFINITION ---
         // ============================================
-        pushScope();
-        
-        // Ripristina variabili catturate
-        for (const auto& pair : fv.capturedVars) {
-            defineVar(pair.first, pair.second, false, false);
-        }
-        
-        // Bind parametri
-        for (size_t i = 0; i < fv.params.size(); ++i) {
-            defineVar(fv.params[i], *args[i], false, false);
+        case NodeKind::FunctionDef: {
+            // Define function in CURRENT scope (local, not global!)
+            currentScope().defineLocalFunction(st->sym, st);
+            invalidateCallCaches();
+    
+            last = 0;
+            return;
         }
-        
-        // Esegui body
-        Value ret = eval(fv.body);
-        
-        popScope();
-        
-        return ret;
-    }
 
+        // --- ArrayDecl ---
+        case NodeKind::ArrayDecl: {
+            bool isDynamic = (st->extra.count("dynamic") &&
+                              st->extra.at("dynamic") == "true");
+            bool isFixed = (st->extra.count("fixed") &&
+                            st->extra.at("fixed") == "true");
+            ArrayValue arr;
 
+            if (st->extra.count("size")) {
+                int size = std::stoi(st->extra.at("size"));
+                arr = makeArrayOfSize(size);
+            }
 
-    // -------- Program --------
-    if (t == "Program") {
-        Value last = 0;
-        for (auto& st : node->children)
-            last = eval(st);
-        return last;
-    }
+            if (!st->children.empty() &&
+                st->children[0] &&
+                st->children[0]->kind == NodeKind::ArrayInit) {
+                auto init = st->children[0];
+                arr.clear();
+                for (auto& ch : init->children)
+                    appendArrayInitExpr(this, arr, ch);
+            }
 
+            // Un array dynamic è destinato a crescere: niente range lazy
+            if (isDynamic) arr.materialize();
 
-    // -------- Body --------
-    if (t == "Body") {
-        Value last = 0;
+            defineVarAt(*st, arr, isDynamic, isFixed);
+            return;
+        }
 
-        for (auto& st : node->children) {
-            if (!st) continue;
+        // --- ArrayAssign ---
+        case NodeKind::ArrayAssign: {
+            auto acc = st->children[0];
+            auto rhs = st->children[1];
+            const std::string& name = acc->value;
 
-            // --- Expression statement ---
-            if (st->type == "ExprStmt") {
-                last = eval(st->children[0]);
-                continue;
+            StoredVar* sv = findVar(*acc);
+            if (!sv) {
+                runtimeError(st.get(), "Array '" + name + "' non definito");
+                return;
             }
-
-            // --- Echo ---
-            if (st->type == "Echo") {
-                Value v = eval(st->children[0]);
-                printValue(v);
-                std::cout << "\n";
-                last = v;
-                continue;
+            if (!sv->isDynamic) {
+                runtimeError(st.get(), "Array '" + name + "' è immutabile");
+                return;
             }
-
-            // --- Assign ---
-            if (st->type == "Assign") {
-                last = evalAssignment(st);
-                continue;
+            if (!isType<ArrayValue>(sv->value)) {
+                runtimeError(st.get(), "'" + name + "' non è un array");
+                return;
             }
 
-            // --- VarDecl ---
-            if (st->type == "VarDecl") {
-                std::string name = st->value;
-                bool isDynamic = (st->extra.count("dynamic") &&
-                                  st->extra.at("dynamic") == "true");
-                bool isFixed = (st->extra.count("fixed") &&
-                                st->extra.at("fixed") == "true");
-                Value val = 0;
-                if (!st->children.empty())
-                    val = eval(st->children[0]);
-                defineVar(name, val, isDynamic, isFixed);
-                continue;
+            Value idxV = eval(acc->children[0]);
+            if (!isType<int>(idxV)) {
+                runtimeError(st.get(), "Indice array deve essere int");
+                return;
             }
-
-            // ============================================
-            // --- NESTED FUNCTION DEFINITION ---
-            // ============================================
-            if (st->type == "FunctionDef") {
-                std::string funcName = st->value;
-                
-                // Define function in CURRENT scope (local, not global!)
-                currentScope().defineLocalFunction(funcName, st);
-                
-                last = 0;
-                continue;
+            int idx = as<int>(idxV);
+            auto& arr = as<ArrayValue>(sv->value);
+            int normIdx = normalizeIndex(idx, arr.size());
+            if (normIdx < 0) {
+                runtimeError(st.get(), "Indice array fuori limite");
+                return;
             }
 
-            // --- ArrayDecl ---
-            if (st->type == "ArrayDecl") {
-                std::string name = st->value;
-                bool isDynamic = (st->extra.count("dynamic") &&
-                                  st->extra.at("dynamic") == "true");
-                bool isFixed = (st->extra.count("fixed") &&
-                                st->extra.at("fixed") == "true");
-                ArrayValue arr;
-
-                if (st->extra.count("size")) {
-                    int size = std::stoi(st->extra.at("size"));
-                    arr = makeArrayOfSize(size);
-                }
+            Value v = eval(rhs);
+            arr.set((size_t)normIdx, v);
 
-                if (!st->children.empty() &&
-                    st->children[0] &&
-                    st->children[0]->type == "ArrayInit") {
-                    auto init = st->children[0];
-                    arr.elements.clear();
-                    for (auto& ch : init->children)
-                        appendArrayInitExpr(this, arr, ch);
-                }
-
-                defineVar(name, arr, isDynamic, isFixed);
-                continue;
-            }
-
-            // --- ArrayAssign ---
-            if (st->type == "ArrayAssign") {
-                auto acc = st->children[0];
-                auto rhs = st->children[1];
-                std::string name = acc->value;
+            return;
+        }
 
-                StoredVar* sv = currentScope().lookup(name);
-                if (!sv) {
-                    runtimeError(st.get(), "Array '" + name + "' non definito");
-                    continue;
-                }
-                if (!sv->isDynamic) {
-                    runtimeError(st.get(), "Array '" + name + "' è immutabile");
-                    continue;
-                }
-                if (!isType<ArrayValue>(sv->value)) {
-                    runtimeError(st.get(), "'" + name + "' non è un array");
-                    continue;
-                }
+        // --- While ---
+        case NodeKind::While: {
+            last = eval(st);
+            return;
+        }
 
-                Value idxV = eval(acc->children[0]);
-                if (!isType<int>(idxV)) {
-                    runtimeError(st.get(), "Indice array deve essere int");
-                    continue;
-                }
-                int idx = as<int>(idxV);
-                auto& arr = as<ArrayValue>(sv->value);
-                int normIdx = normalizeIndex(idx, arr.size());
-                if (normIdx < 0) {
-                    runtimeError(st.get(), "Indice array fuori limite");
-                    continue;
-                }
+        // --- ForIn ---
+        case NodeKind::ForIn: {
+            last = eval(st);
+            return;
+        }
 
-                Value v = eval(rhs);
-                if (!arr[(size_t)normIdx])
-                    arr[(size_t)normIdx] = std::make_shared<Value>(v);
-                else
-                    *arr[(size_t)normIdx] = v;
+        default:
+            break;
+    }
 
-                continue;
-            }
+    // --- Unknown ---
+    runtimeError(st.get(), "Tipo statement non gestito in Body: " + st->type);
+}
 
-            // --- FunctionDef ---
-            if (st->type == "FunctionDef") {
-                functions[st->value] = st;
-                continue;
-            }
 
-            // --- While ---
-            if (st->type == "While") {
-                last = eval(st);
-                continue;
-            }
+// =======================
+// Accesso con indice singolo (ArrayAccess, VM)
+// =======================
 
-            // --- ForIn ---
-            if (st->type == "ForIn") {
-                last = eval(st);
-                continue;
-            }
+Value Interpreter::indexValue(const Value& arrayVal, const Value& idxV, const ASTNode* node) {
+    if (!isType<int>(idxV)) {
+        runtimeError(node, "Indice deve essere int");
+        return 0;
+    }
+    int idx = as<int>(idxV);
 
-            // --- Unknown ---
-            runtimeError(st.get(), "Tipo statement non gestito in Body: " + st->type);
+    // Stringa → singolo carattere
+    if (isType<std::string>(arrayVal)) {
+        const Utf8Index& strIdx = utf8IndexOf(arrayVal);
+        if (!strIdx.valid) {
+            runtimeError(node, "Errore UTF-8: " + strIdx.error);
+            return "";
         }
-
-        return last;
+        int normIdx = normalizeIndex(idx, strIdx.length);
+        if (normIdx < 0) {
+            runtimeError(node, "Indice stringa fuori limite");
+            return "";
+        }
+        return utf8Codepoints(as<std::string>(arrayVal), strIdx, normIdx, 1);
     }
 
+    // Array
+    if (isType<ArrayValue>(arrayVal)) {
+        auto& arr = as<ArrayValue>(arrayVal);
+        int normIdx = normalizeIndex(idx, arr.size());
+        if (normIdx < 0) {
+            runtimeError(node, "Indice array fuori limite");
+            return 0;
+        }
+        return arr.get((size_t)normIdx);
+    }
 
-
-
-    runtimeError(node.get(), "Nodo non gestito in eval(): " + node->type);
+    runtimeError(node, "Valore non indicizzabile (richiesto array o stringa)");
     return 0;
 }
 
@@ -1569,292 +1312,291 @@ Value Interpreter::eval(const std::shared_ptr<ASTNode>& node) {
 // Operatori
 // =======================
 
-// =======================
-// SEZIONE DA SOSTITUIRE in evalBinaryOp
-// Cerca "1) Operatori aritmetici" e sostituisci TUTTO il blocco fino a "2) Confronti numerici"
-// =======================
+static inline bool isNumber(const Value& v) {
+    return v.tag == Value::Tag::Int || v.tag == Value::Tag::Double;
+}
 
-Value Interpreter::evalBinaryOp(const std::string& op,
-                                Value left,
-                                Value right,
+// Valore numerico di un int/double (precondizione: isNumber)
+static inline double numberOf(const Value& v) {
+    return v.tag == Value::Tag::Int ? static_cast<double>(as<int>(v)) : as<double>(v);
+}
+
+Value Interpreter::evalBinaryOp(Operator op,
+                                const Value& left,
+                                const Value& right,
                                 const ASTNode* node)
 {
     // ============================================================
-    // 1) Operatori aritmetici + - * / % **
+    // 1) Numerici: dispatch su (operatore, tag sinistro, tag destro)
     // ============================================================
-    if (op == "+" || op == "-" || op == "*" || op == "/" || op == "%" || op == "**") {
-
-        bool li = isType<int>(left);
-        bool ld = isType<double>(left);
-        bool ri = isType<int>(right);
-        bool rd = isType<double>(right);
-
-        // ========== INT + INT ==========
-        if (li && ri) {
-            int L = as<int>(left);
-            int R = as<int>(right);
-
-            if (op == "+") return L + R;
-            if (op == "-") return L - R;
-            if (op == "*") return L * R;
-            if (op == "/") {
+
+    // ========== INT op INT ==========
+    if (left.tag == Value::Tag::Int && right.tag == Value::Tag::Int) {
+        int L = as<int>(left);
+        int R = as<int>(right);
+
+        switch (op) {
+            case Operator::Add: return L + R;
+            case Operator::Sub: return L - R;
+            case Operator::Mul: return L * R;
+            case Operator::Div:
                 if (R == 0) {
                     runtimeError(node, "Divisione per zero");
                     return 0;
                 }
                 return L / R;
-            }
-            if (op == "%") {
+            case Operator::Mod:
                 if (R == 0) {
                     runtimeError(node, "Modulo per zero");
                     return 0;
                 }
                 return L % R;
-            }
-            if (op == "**") {
+            case Operator::Pow:
                 // Potenza: int ** int → double
                 return std::pow(static_cast<double>(L), static_cast<double>(R));
-            }
-        }
 
-        // ========== DOUBLE + DOUBLE ==========
-        if (ld && rd) {
-            double L = as<double>(left);
-            double R = as<double>(right);
+            case Operator::Lt: return (L <  R) ? 1 : 0;
+            case Operator::Le: return (L <= R) ? 1 : 0;
+            case Operator::Gt: return (L >  R) ? 1 : 0;
+            case Operator::Ge: return (L >= R) ? 1 : 0;
 
-            if (op == "+") return L + R;
-            if (op == "-") return L - R;
-            if (op == "*") return L * R;
-            if (op == "/") {
-                if (R == 0.0) {
-                    runtimeError(node, "Divisione per zero");
-                    return 0.0;
-                }
-                return L / R;
-            }
-            if (op == "%") {
-                runtimeError(node, "Modulo (%) non supportato per double, solo int");
-                return 0.0;
-            }
-            if (op == "**") {
-                // Potenza: double ** double → double
-                return std::pow(L, R);
-            }
+            // Due int hanno la stessa forma testuale solo se sono uguali
+            case Operator::Eq: return (L == R) ? 1 : 0;
+            case Operator::Ne: return (L != R) ? 1 : 0;
+
+            default: break;
         }
+    }
 
-        // ========== INT + DOUBLE (promozione a double) ==========
-        if ((li && rd) || (ld && ri)) {
-            double L = li ? static_cast<double>(as<int>(left)) : as<double>(left);
-            double R = ri ? static_cast<double>(as<int>(right)) : as<double>(right);
+    // ========== DOUBLE op DOUBLE / INT op DOUBLE (promozione a double) ==========
+    else if (isNumber(left) && isNumber(right)) {
+        double L = numberOf(left);
+        double R = numberOf(right);
 
-            if (op == "+") return L + R;
-            if (op == "-") return L - R;
-            if (op == "*") return L * R;
-            if (op == "/") {
+        switch (op) {
+            case Operator::Add: return L + R;
+            case Operator::Sub: return L - R;
+            case Operator::Mul: return L * R;
+            case Operator::Div:
                 if (R == 0.0) {
                     runtimeError(node, "Divisione per zero");
                     return 0.0;
                 }
                 return L / R;
-            }
-            if (op == "%") {
-                runtimeError(node, "Modulo (%) richiede entrambi int");
+            case Operator::Mod:
+                if (left.tag == Value::Tag::Double && right.tag == Value::Tag::Double)
+                    runtimeError(node, "Modulo (%) non supportato per double, solo int");
+                else
+                    runtimeError(node, "Modulo (%) richiede entrambi int");
                 return 0.0;
-            }
-            if (op == "**") {
+            case Operator::Pow:
                 return std::pow(L, R);
-            }
-        }
 
-        runtimeError(node,
-            "Operatore '" + op + "' non definito per i tipi forniti (" +
-            typeOfValue(left) + " e " + typeOfValue(right) + ")");
-        return 0;
-    }
-    // ============================================================
-    // 2) Confronti numerici < <= > >=
-    // ============================================================
-    if (op == "<" || op == "<=" || op == ">" || op == ">=") {
-
-        double L, R;
-        bool okL = false, okR = false;
+            case Operator::Lt: return (L <  R) ? 1 : 0;
+            case Operator::Le: return (L <= R) ? 1 : 0;
+            case Operator::Gt: return (L >  R) ? 1 : 0;
+            case Operator::Ge: return (L >= R) ? 1 : 0;
 
-        if (isType<int>(left))   { L = as<int>(left);   okL = true; }
-        if (isType<double>(left)){ L = as<double>(left); okL = true; }
-
-        if (isType<int>(right))   { R = as<int>(right);   okR = true; }
-        if (isType<double>(right)){ R = as<double>(right); okR = true; }
+            default: break;
+        }
+    }
 
-        if (!okL) {
-            runtimeError(node, "Confronto non definito per tipo sinistro " + typeOfValue(left));
+    switch (op) {
+        // ============================================================
+        // 2) Aritmetici su tipi non numerici
+        // ============================================================
+        case Operator::Add:
+        case Operator::Sub:
+        case Operator::Mul:
+        case Operator::Div:
+        case Operator::Mod:
+        case Operator::Pow:
+            runtimeError(node,
+                std::string("Operatore '") + operatorName(op) +
+                "' non definito per i tipi forniti (" +
+                typeOfValue(left) + " e " + typeOfValue(right) + ")");
             return 0;
-        }
-        if (!okR) {
+
+        // ============================================================
+        // 3) Confronti numerici su tipi non numerici
+        // ============================================================
+        case Operator::Lt:
+        case Operator::Le:
+        case Operator::Gt:
+        case Operator::Ge:
+            if (!isNumber(left)) {
+                runtimeError(node, "Confronto non definito per tipo sinistro " + typeOfValue(left));
+                return 0;
+            }
             runtimeError(node, "Confronto non definito per tipo destro " + typeOfValue(right));
             return 0;
-        }
 
-        if (op == "<")  return (L <  R) ? 1 : 0;
-        if (op == "<=") return (L <= R) ? 1 : 0;
-        if (op == ">")  return (L >  R) ? 1 : 0;
-        if (op == ">=") return (L >= R) ? 1 : 0;
-    }
+        // ============================================================
+        // 4) Uguaglianza
+        // ============================================================
+        case Operator::Eq: return valuesEqual(left, right) ? 1 : 0;
+        case Operator::Ne: return valuesEqual(left, right) ? 0 : 1;
 
-    // ============================================================
-    // 3) Uguaglianza
-    // ============================================================
-    if (op == "==") return (toString(left) == toString(right)) ? 1 : 0;
-    if (op == "!=") return (toString(left) != toString(right)) ? 1 : 0;
+        // ============================================================
+        // 5) Logici
+        // ============================================================
+        case Operator::And: return (isTruthy(left) && isTruthy(right)) ? 1 : 0;
+        case Operator::Or:  return (isTruthy(left) || isTruthy(right)) ? 1 : 0;
 
-    // ============================================================
-    // 4) Logici
-    // ============================================================
-    if (op == "and") return (isTruthy(left) && isTruthy(right)) ? 1 : 0;
-    if (op == "or")  return (isTruthy(left) || isTruthy(right)) ? 1 : 0;
+        // ============================================================
+        // 6) Concatenazione
+        // ============================================================
+        case Operator::Concat: return evalConcat(left, right, node);
+
+        default: break;
+    }
 
     // ============================================================
-    // 5) OPERATORE $ — CONCATENAZIONE UNIVERSALE
+    // 7) Operatore sconosciuto
     // ============================================================
-    if (op == "$") {
-
-        // -- STRING + STRING -------------------------------------
-        if (isType<std::string>(left) && isType<std::string>(right)) {
-            return as<std::string>(left) + as<std::string>(right);
-        }
-
-        // NOTA: Range è gestito in eval() prima di chiamare evalBinaryOp
-        // quindi qui non dovremmo mai ricevere RangeInfo
-
-        // -- ARRAY + ARRAY → concat immutabile
-        if (isType<ArrayValue>(left) && isType<ArrayValue>(right)) {
-            ArrayValue out;
-            const auto& A = as<ArrayValue>(left);
-            const auto& B = as<ArrayValue>(right);
-
-            out.elements.reserve(A.size() + B.size());
-
-            for (auto& e : A.elements)
-                out.elements.push_back(std::make_shared<Value>(*e));
-
-            for (auto& e : B.elements)
-                out.elements.push_back(std::make_shared<Value>(*e));
-
-            return out;
-        }
-
-        // NOTA: ARRAY + RANGE è gestito in eval() prima di chiamare evalBinaryOp
-
-        // -- FUNCTION + FUNCTION → COMPOSIZIONE
-        if (isType<FunctionValue>(left) && isType<FunctionValue>(right)) {
-            // f $ g crea una nuova funzione composta: (f $ g)(x) = g(f(x))
+    runtimeError(node, "Operatore binario non gestito: " +
+                       (node ? node->value : std::string(operatorName(op))));
+    return 0;
+}
 
-            const auto& f = as<FunctionValue>(left);
-            const auto& g = as<FunctionValue>(right);
 
-            // Controllo numero parametri (per ora solo funzioni unarie)
-            if (f.params.size() != 1) {
-                runtimeError(node,
-                    "Composizione richiede funzione con 1 parametro (prima funzione ha " +
-                    std::to_string(f.params.size()) + " parametri)");
-                return 0;
-            }
+// ============================================================
+// OPERATORE $ — CONCATENAZIONE UNIVERSALE
+// ============================================================
+Value Interpreter::evalConcat(const Value& left,
+                              const Value& right,
+                              const ASTNode* node)
+{
+    // -- STRING + STRING -------------------------------------
+    if (isType<std::string>(left) && isType<std::string>(right)) {
+        return as<std::string>(left) + as<std::string>(right);
+    }
 
-            if (g.params.size() != 1) {
-                runtimeError(node,
-                    "Composizione richiede funzione con 1 parametro (seconda funzione ha " +
-                    std::to_string(g.params.size()) + " parametri)");
-                return 0;
-            }
+    // NOTA: Range è gestito in eval() prima di chiamare evalBinaryOp
+    // quindi qui non dovremmo mai ricevere RangeInfo
 
-            // Crea nuova funzione composta
-            FunctionValue composed;
-            composed.params = f.params;  // Stessi parametri della prima funzione
+    // -- ARRAY + ARRAY → concat immutabile
+    if (isType<ArrayValue>(left) && isType<ArrayValue>(right)) {
+        ArrayValue out;
+        const auto& A = as<ArrayValue>(left);
+        const auto& B = as<ArrayValue>(right);
 
-            // Crea AST per: g(f(param))
-            // Questo è complicato, per ora salviamo le due funzioni e gestiamo a runtime
-            composed.extra["composed"] = "true";
-            composed.extra["first"] = "f";
-            composed.extra["second"] = "g";
+        out.reserve(A.size() + B.size());
+        out.append(A);
+        out.append(B);
 
-            // Salviamo le funzioni originali nel closure
-            // (Questo richiede una struttura dati più complessa)
-            // Per ora, creiamo un wrapper
+        return out;
+    }
 
-            // SOLUZIONE SEMPLICE: Salviamo f e g come variabili temporanee
-            // e creiamo un body che le chiama
+    // NOTA: ARRAY + RANGE è gestito in eval() prima di chiamare evalBinaryOp
 
-            // Alternativa migliore: salviamo i FunctionValue nel composed stesso
-            composed.composedFuncs.push_back(std::make_shared<FunctionValue>(f));
-            composed.composedFuncs.push_back(std::make_shared<FunctionValue>(g));
+    // -- FUNCTION + FUNCTION → COMPOSIZIONE
+    if (isType<FunctionValue>(left) && isType<FunctionValue>(right)) {
+        // f $ g crea una nuova funzione composta: (f $ g)(x) = g(f(x))
 
-            return composed;
-        }
+        const auto& f = as<FunctionValue>(left);
+        const auto& g = as<FunctionValue>(right);
 
-        // -- INT + INT → ERRORE (conversione esplicita richiesta)
-        if (isType<int>(left) && isType<int>(right)) {
+        // Controllo numero parametri (per ora solo funzioni unarie)
+        if (f.params.size() != 1) {
             runtimeError(node,
-                "Concatenazione '$' non supporta int direttamente.\n"
-                "Usa conversione esplicita: str(123) $ str(456)");
+                "Composizione richiede funzione con 1 parametro (prima funzione ha " +
+                std::to_string(f.params.size()) + " parametri)");
             return 0;
         }
 
-        // -- DOUBLE + DOUBLE → ERRORE (conversione esplicita richiesta)
-        if (isType<double>(left) && isType<double>(right)) {
+        if (g.params.size() != 1) {
             runtimeError(node,
-                "Concatenazione '$' non supporta double direttamente.\n"
-                "Usa conversione esplicita: str(3.14) $ str(2.71)");
+                "Composizione richiede funzione con 1 parametro (seconda funzione ha " +
+                std::to_string(g.params.size()) + " parametri)");
             return 0;
         }
 
+        // Crea nuova funzione composta
+        FunctionValue composed;
+        composed.params = f.params;  // Stessi parametri della prima funzione
+
+        // Crea AST per: g(f(param))
+        // Questo è complicato, per ora salviamo le due funzioni e gestiamo a runtime
+        composed.extra["composed"] = "true";
+        composed.extra["first"] = "f";
+        composed.extra["second"] = "g";
+
+        // Salviamo le funzioni originali nel closure
+        // (Questo richiede una struttura dati più complessa)
+        // Per ora, creiamo un wrapper
+
+        // SOLUZIONE SEMPLICE: Salviamo f e g come variabili temporanee
+        // e creiamo un body che le chiama
+
+        // Alternativa migliore: salviamo i FunctionValue nel composed stesso
+        composed.composedFuncs.push_back(std::make_shared<FunctionValue>(f));
+        composed.composedFuncs.push_back(std::make_shared<FunctionValue>(g));
+
+        return composed;
+    }
+
+    // -- INT + INT → ERRORE (conversione esplicita richiesta)
+    if (isType<int>(left) && isType<int>(right)) {
         runtimeError(node,
-            "Concatenazione '$' richiede tipi uguali e concatenabili (string, array, funzioni).\n"
-            "Trovato: " + typeOfValue(left) + " e " + typeOfValue(right));
+            "Concatenazione '$' non supporta int direttamente.\n"
+            "Usa conversione esplicita: str(123) $ str(456)");
         return 0;
     }
 
-    // ============================================================
-    // 6) Operatore sconosciuto
-    // ============================================================
-    runtimeError(node, "Operatore binario non gestito: " + op);
+    // -- DOUBLE + DOUBLE → ERRORE (conversione esplicita richiesta)
+    if (isType<double>(left) && isType<double>(right)) {
+        runtimeError(node,
+            "Concatenazione '$' non supporta double direttamente.\n"
+            "Usa conversione esplicita: str(3.14) $ str(2.71)");
+        return 0;
+    }
+
+    runtimeError(node,
+        "Concatenazione '$' richiede tipi uguali e concatenabili (string, array, funzioni).\n"
+        "Trovato: " + typeOfValue(left) + " e " + typeOfValue(right));
     return 0;
 }
 
 
-Value Interpreter::evalUnaryOp(const std::string& op,
+Value Interpreter::evalUnaryOp(Operator op,
                                const Value& val,
                                const ASTNode* node)
 {
-    // -------------------------
-    // Operatore unario "-"
-    // -------------------------
-    if (op == "-") {
+    switch (op) {
+        // -------------------------
+        // Operatore unario "-"
+        // -------------------------
+        case Operator::Neg:
+            if (val.tag == Value::Tag::Int)
+                return -as<int>(val);
 
-        if (isType<int>(val))
-            return -as<int>(const_cast<Value&>(val));
+            if (val.tag == Value::Tag::Double)
+                return -as<double>(val);
 
-        if (isType<double>(val))
-            return -as<double>(const_cast<Value&>(val));
+            runtimeError(node,
+                "Operatore unario '-' non definito per tipo " +
+                typeOfValue(val));
 
-        runtimeError(node,
-            "Operatore unario '-' non definito per tipo " +
-            typeOfValue(val));
+            return 0;
 
-        return 0;
-    }
+        // -------------------------
+        // Operatore unario "!"
+        // -------------------------
+        case Operator::Not:
+            // Mammuth: "!" applicato a qualunque valore → truthiness standard
+            return isTruthy(val) ? 0 : 1;
 
-    // -------------------------
-    // Operatore unario "!"
-    // -------------------------
-    if (op == "!") {
-        // Mammuth: "!" applicato a qualunque valore → truthiness standard
-        return isTruthy(val) ? 0 : 1;
+        default:
+            break;
     }
 
     // -------------------------
     // Operatore sconosciuto
     // -------------------------
     runtimeError(node,
-        "Operatore unario non gestito: '" + op + "'");
+        "Operatore unario non gestito: '" +
+        (node ? node->value : std::string(operatorName(op))) + "'");
 
     return 0;
 }
@@ -1886,7 +1628,7 @@ Value Interpreter::evalCondChain(const std::shared_ptr<ASTNode>& node) {
 
         auto condNode = node->children[i];
 
-        if (!condNode || condNode->type != "SimpleCond")
+        if (!condNode || condNode->kind != NodeKind::SimpleCond)
             continue;
 
         // SimpleCond ha 2 figli:
@@ -1931,64 +1673,549 @@ Value Interpreter::evalFilter(const std::shared_ptr<ASTNode>& node) {
         return 0;
     }
 
+    // Catena a => p1 => p2 => ...: l'AST è Filter(Filter(a, p1), p2).
+    // Gli stadi sono fusi in un solo passaggio: ogni elemento attraversa
+    // i predicati in ordine e nessun array intermedio viene costruito.
+    std::vector<const ASTNode*> stages;     // dal più interno (p1) all'esterno
+    const ASTNode* inner = node.get();
+    stages.push_back(inner);
+    while (inner->children[0] &&
+           inner->children[0]->kind == NodeKind::Filter &&
+           inner->children[0]->children.size() >= 2) {
+        inner = inner->children[0].get();
+        stages.push_back(inner);
+    }
+    std::reverse(stages.begin(), stages.end());
+
     // Evaluate left side (should be an array)
-    Value leftVal = eval(node->children[0]);
+    const Value leftVal = eval(inner->children[0]);
 
     if (!isType<ArrayValue>(leftVal)) {
-        runtimeError(node.get(), "Filter (=>) si applica solo ad array, ricevuto: " +
+        runtimeError(inner, "Filter (=>) si applica solo ad array, ricevuto: " +
                     typeOfValue(leftVal));  // ← FIX 1: typeOfValue
+        // Ogni stadio successivo riceve lo 0 dello stadio fallito
+        for (size_t s = 1; s < stages.size(); ++s)
+            runtimeError(stages[s], "Filter (=>) si applica solo ad array, ricevuto: int");
         return 0;
     }
 
-    auto& inputArray = as<ArrayValue>(leftVal);
+    const auto& inputArray = as<ArrayValue>(leftVal);
+    size_t n = inputArray.size();
 
-    // Create result array
+    // Create result array (stesso storage tipizzato dell'input)
     ArrayValue resultArray;
     // FIX 2: Rimossa riga elementType - non esiste in ArrayValue!
 
-    // Get the condition expression
-    auto condExpr = node->children[1];
+    // I worker non hanno un pool: i filter annidati nei loro predicati
+    // restano sequenziali
+    bool parallel = filterPool && n >= PARALLEL_FILTER_MIN;
+    for (const ASTNode* stage : stages)
+        parallel = parallel && stage->pure;
 
-    // For each element in input array
-    for (const auto& element : inputArray.elements) {
-        // Push a temporary scope
-        pushScope();
+    if (!parallel) {
+        filterRange(stages, inputArray, 0, n, resultArray);
+        return resultArray;
+    }
+
+    // ⭐ Predicati puri su array grandi: una porzione contigua per thread
+    // del pool, ognuna con un Interpreter worker (scope e cache propri).
+    // Risultati ed errori sono ricomposti nell'ordine delle porzioni,
+    // come in sequenza.
+    size_t chunks = threads;
+    while (filterWorkers.size() < chunks)
+        filterWorkers.emplace_back(new Interpreter(*this));
+
+    std::vector<ArrayValue> parts(chunks);
+    std::vector<std::ostringstream> partErrors(chunks);
+    for (size_t c = 0; c < chunks; ++c) {
+        filterWorkers[c]->borrowScopes(*this);
+        filterWorkers[c]->errors = &partErrors[c];
+    }
+
+    filterPool->run(chunks, [&](size_t c) {
+        filterWorkers[c]->filterRange(stages, inputArray,
+                                      n * c / chunks, n * (c + 1) / chunks, parts[c]);
+    });
+
+    DEBUG_INTERP_LOG("Filter parallelo: " << n << " elementi su " << chunks << " thread");
+
+    for (size_t c = 0; c < chunks; ++c) {
+        *errors << partErrors[c].str();
+        resultArray.append(parts[c]);
+    }
+
+    return resultArray;
+}
+
+void Interpreter::filterRange(const std::vector<const ASTNode*>& stages,
+                              const ArrayValue& input,
+                              size_t begin, size_t end,
+                              ArrayValue& out)
+{
+    // Un solo scope per tutto il passaggio: per ogni elemento e stadio
+    // viene rinnovato con il layout del predicato ('x' è lo slot 0)
+    pushScope(nullptr);
+    Scope& scope = currentScope();
 
-        // Define implicit variable 'x' with current element
+    // For each element in input array
+    for (size_t i = begin; i < end; ++i) {
+        // Implicit variable 'x' with current element
         StoredVar sv;
-        sv.value = *element;  // ← FIX 3: Dereferenzia!
+        sv.value = input.get(i);
         sv.isDynamic = false;
         sv.isFixed = true;  // x is immutable in filter context
-        currentScope().define("x", sv);
+        bool keep = true;
+
+        for (const ASTNode* stage : stages) {
+            const auto& condExpr = stage->children[1];
 
-        DEBUG_SCOPE_LOG("Filter: defineVar 'x' (implicit) with element value");
+            if (!scope.localFunctions.empty()) invalidateCallCaches();
+            scope.renew(condExpr->frame.get());
 
-        // Evaluate the condition with 'x' bound to current element
-        Value condResult = eval(condExpr);
+            if (condExpr->frame)
+                scope.defineSlot(0, sv);
+            else
+                scope.define(filterItem, sv);
 
-        // Pop the temporary scope
-        popScope();
+            DEBUG_SCOPE_LOG("Filter: defineVar 'x' (implicit) with element value");
+
+            // Evaluate the condition with 'x' bound to current element;
+            // il primo predicato falso scarta l'elemento
+            if (!isTruthy(eval(condExpr))) {
+                keep = false;
+                break;
+            }
+        }
 
-        // If condition is truthy, include element in result
-        if (isTruthy(condResult)) {
-            resultArray.elements.push_back(element);
+        if (keep) {
+            out.push_back(sv.value);
         }
     }
 
-    return resultArray;
+    popScope();
+}
+
+// =======================
+// Builtin
+// =======================
+
+// Tabella dei builtin, nell'ordine di BuiltinId
+const Interpreter::Builtin Interpreter::builtins[] = {
+    { 1,  1, BuiltinArgs::Values, &Interpreter::builtinStr,         Value::Tag::String,
+      "str() richiede esattamente 1 argomento" },
+    { 1,  1, BuiltinArgs::Values, &Interpreter::builtinLen,         Value::Tag::Int,
+      "len() richiede esattamente 1 argomento" },
+    { 2,  2, BuiltinArgs::Values, &Interpreter::builtinRandInt,     Value::Tag::Int,
+      "randInt() richiede 2 argomenti (min, max)" },
+    { 0,  0, BuiltinArgs::Values, &Interpreter::builtinRandDouble,  Value::Tag::Int,
+      "randDouble() non accetta argomenti" },
+    { 2,  2, BuiltinArgs::Raw,    &Interpreter::builtinArrayPush,   Value::Tag::Int,
+      "array_push() richiede 2 argomenti (array, value)" },
+    { 1,  1, BuiltinArgs::Raw,    &Interpreter::builtinArrayPop,    Value::Tag::Int,
+      "array_pop() richiede 1 argomento (array)" },
+    { 1,  1, BuiltinArgs::Values, &Interpreter::builtinArrayLength, Value::Tag::Int,
+      "array_length() richiede 1 argomento" },
+    { 1,  1, BuiltinArgs::Values, &Interpreter::builtinArrayFirst,  Value::Tag::Int,
+      "array_first() richiede 1 argomento" },
+    { 1,  1, BuiltinArgs::Values, &Interpreter::builtinArrayLast,   Value::Tag::Int,
+      "array_last() richiede 1 argomento" },
+    { 1,  1, BuiltinArgs::Values, &Interpreter::builtinToInt,       Value::Tag::Int,
+      "toInt() richiede 1 argomento" },
+    { 1,  1, BuiltinArgs::Values, &Interpreter::builtinToDouble,    Value::Tag::Double,
+      "toDouble() richiede 1 argomento" },
+    { 1,  1, BuiltinArgs::Values, &Interpreter::builtinTypeOf,      Value::Tag::String,
+      "typeOf() richiede 1 argomento" },
+    { 0, -1, BuiltinArgs::Raw,    &Interpreter::builtinInput,       Value::Tag::Int,
+      "" },
+    { 1,  3, BuiltinArgs::Values, &Interpreter::builtinRange,       Value::Tag::Array,
+      "range(): richiede 1, 2 o 3 argomenti" },
+};
+
+Value Interpreter::callBuiltin(const ASTNode& call) {
+    static_assert(sizeof(builtins) / sizeof(builtins[0]) == BUILTIN_COUNT,
+                  "Interpreter::builtins deve seguire BuiltinId");
+
+    const Builtin& b = builtins[call.builtin];
+    int argc = static_cast<int>(call.children.size());
+
+    if (argc < b.minArgs || (b.maxArgs >= 0 && argc > b.maxArgs)) {
+        runtimeError(&call, b.arityError);
+        switch (b.errorTag) {
+            case Value::Tag::Double: return 0.0;
+            case Value::Tag::String: return "";
+            case Value::Tag::Array:  return ArrayValue{};
+            default:                 return 0;
+        }
+    }
+
+    DEBUG_INTERP_LOG("builtin " << builtinName(call.builtin) << "(), argc=" << argc);
+
+    std::vector<Value> args;
+    if (b.args == BuiltinArgs::Values) {
+        args.reserve(argc);
+        for (auto& ch : call.children)
+            args.push_back(eval(ch));
+    }
+    return (this->*b.fn)(call, args);
+}
+
+// --- str() ---
+Value Interpreter::builtinStr(const ASTNode&, std::vector<Value>& args) {
+    return toString(args[0]);
+}
+
+// --- len() ---
+Value Interpreter::builtinLen(const ASTNode& call, std::vector<Value>& args) {
+    const Value& arg = args[0];
+    if (isType<std::string>(arg)) {
+        const Utf8Index& idx = utf8IndexOf(arg);
+        if (!idx.valid) throw Utf8Error(idx.error);
+        return static_cast<int>(idx.length);
+    }
+    if (isType<ArrayValue>(arg)) {
+        return static_cast<int>(as<ArrayValue>(arg).size());
+    }
+    runtimeError(&call, "len() supporta solo string e array");
+    return 0;
+}
+
+// --- randInt(min, max) → int in [min, max) ---
+Value Interpreter::builtinRandInt(const ASTNode& call, std::vector<Value>& args) {
+    const Value& minVal = args[0];
+    const Value& maxVal = args[1];
+
+    if (!isType<int>(minVal) || !isType<int>(maxVal)) {
+        runtimeError(&call, "randInt(): argomenti devono essere int");
+        return 0;
+    }
+
+    int min = as<int>(minVal);
+    int max = as<int>(maxVal);
+
+    if (min >= max) {
+        runtimeError(&call, "randInt(): min deve essere < max");
+        return 0;
+    }
+
+    // Generate random int in [min, max)
+    static bool seeded = false;
+    if (!seeded) {
+        std::srand(static_cast<unsigned>(std::time(nullptr)));
+        seeded = true;
+    }
+
+    int range = max - min;
+    int randomInt = min + (std::rand() % range);
+    return randomInt;
+}
+
+// --- randDouble() → double in [0.0, 1.0) ---
+Value Interpreter::builtinRandDouble(const ASTNode&, std::vector<Value>&) {
+    // Generate random double in [0.0, 1.0)
+    static bool seeded = false;
+    if (!seeded) {
+        std::srand(static_cast<unsigned>(std::time(nullptr)));
+        seeded = true;
+    }
+
+    double randomDouble = static_cast<double>(std::rand()) / RAND_MAX;
+    return randomDouble;
+}
+
+// --- array_push(): primo argomento = nome dell'array, modificato in place ---
+Value Interpreter::builtinArrayPush(const ASTNode& call, std::vector<Value>&) {
+    if (call.children[0]->kind != NodeKind::Identifier) {
+        runtimeError(&call, "array_push(): primo argomento deve essere nome array");
+        return 0;
+    }
+
+    const std::string& arrName = call.children[0]->value;
+    auto sv = findVar(*call.children[0]);
+    if (!sv) {
+        runtimeError(&call, "Array '" + arrName + "' non definito");
+        return 0;
+    }
+
+    if (!isType<ArrayValue>(sv->value)) {
+        runtimeError(&call, "'" + arrName + "' non è un array");
+        return 0;
+    }
+
+    if (!sv->isDynamic) {
+        runtimeError(&call, "Array '" + arrName + "' non è dynamic");
+        return 0;
+    }
+
+    Value newVal = eval(call.children[1]);
+    as<ArrayValue>(sv->value).push_back(newVal);
+    return 0;
+}
+
+// --- array_pop() ---
+Value Interpreter::builtinArrayPop(const ASTNode& call, std::vector<Value>&) {
+    if (call.children[0]->kind != NodeKind::Identifier) {
+        runtimeError(&call, "array_pop(): argomento deve essere nome array");
+        return 0;
+    }
+
+    const std::string& arrName = call.children[0]->value;
+    auto sv = findVar(*call.children[0]);
+    if (!sv) {
+        runtimeError(&call, "Array '" + arrName + "' non definito");
+        return 0;
+    }
+
+    if (!isType<ArrayValue>(sv->value)) {
+        runtimeError(&call, "'" + arrName + "' non è un array");
+        return 0;
+    }
+
+    if (!sv->isDynamic) {
+        runtimeError(&call, "Array '" + arrName + "' non è dynamic");
+        return 0;
+    }
+
+    auto& arr = as<ArrayValue>(sv->value);
+    if (arr.empty()) {
+        runtimeError(&call, "array_pop(): array vuoto");
+        return 0;
+    }
+
+    Value ret = arr.back();
+    arr.pop_back();
+    return ret;
+}
+
+// --- array_length() ---
+Value Interpreter::builtinArrayLength(const ASTNode& call, std::vector<Value>& args) {
+    const Value& arg = args[0];
+    if (!isType<ArrayValue>(arg)) {
+        runtimeError(&call, "array_length() supporta solo array");
+        return 0;
+    }
+    return static_cast<int>(as<ArrayValue>(arg).size());
+}
+
+// --- array_first() ---
+Value Interpreter::builtinArrayFirst(const ASTNode& call, std::vector<Value>& args) {
+    const Value& arg = args[0];
+    if (!isType<ArrayValue>(arg)) {
+        runtimeError(&call, "array_first() supporta solo array");
+        return 0;
+    }
+    auto& arr = as<ArrayValue>(arg);
+    if (arr.empty()) {
+        runtimeError(&call, "array_first(): array vuoto");
+        return 0;
+    }
+    return arr.get(0);
+}
+
+// --- array_last() ---
+Value Interpreter::builtinArrayLast(const ASTNode& call, std::vector<Value>& args) {
+    const Value& arg = args[0];
+    if (!isType<ArrayValue>(arg)) {
+        runtimeError(&call, "array_last() supporta solo array");
+        return 0;
+    }
+    auto& arr = as<ArrayValue>(arg);
+    if (arr.empty()) {
+        runtimeError(&call, "array_last(): array vuoto");
+        return 0;
+    }
+    return arr.back();
+}
+
+// --- toInt() ---
+Value Interpreter::builtinToInt(const ASTNode& call, std::vector<Value>& args) {
+    const Value& arg = args[0];
+    if (isType<int>(arg)) return arg;
+    if (isType<double>(arg)) return static_cast<int>(as<double>(arg));
+    if (isType<std::string>(arg)) {
+        try {
+            return std::stoi(as<std::string>(arg));
+        } catch (...) {
+            runtimeError(&call, "toInt(): conversione fallita");
+            return 0;
+        }
+    }
+    runtimeError(&call, "toInt() non supporta questo tipo");
+    return 0;
+}
+
+// --- toDouble() ---
+Value Interpreter::builtinToDouble(const ASTNode& call, std::vector<Value>& args) {
+    const Value& arg = args[0];
+    if (isType<double>(arg)) return arg;
+    if (isType<int>(arg)) return static_cast<double>(as<int>(arg));
+    if (isType<std::string>(arg)) {
+        try {
+            return std::stod(as<std::string>(arg));
+        } catch (...) {
+            runtimeError(&call, "toDouble(): conversione fallita");
+            return 0.0;
+        }
+    }
+    runtimeError(&call, "toDouble() non supporta questo tipo");
+    return 0.0;
+}
+
+// --- typeOf() ---
+Value Interpreter::builtinTypeOf(const ASTNode&, std::vector<Value>& args) {
+    return typeOfValue(args[0]);
+}
+
+// --- input(): gli argomenti non vengono valutati ---
+Value Interpreter::builtinInput(const ASTNode&, std::vector<Value>&) {
+    std::string line;
+    std::getline(std::cin, line);
+    return line;
+}
+
+// --- range(end) / range(start, end) / range(start, end, step) ---
+Value Interpreter::builtinRange(const ASTNode& call, std::vector<Value>& args) {
+    for (const Value& a : args) {
+        if (!isType<int>(a)) {
+            runtimeError(&call, args.size() == 1 ? "range(): argomento deve essere int"
+                                                 : "range(): argomenti devono essere int");
+            return ArrayValue{};
+        }
+    }
+
+    int start = 0, end = 0, step = 1;
+    if (args.size() == 1) {
+        end = as<int>(args[0]);
+    } else {
+        start = as<int>(args[0]);
+        end = as<int>(args[1]);
+        if (args.size() == 3) {
+            step = as<int>(args[2]);
+            if (step == 0) {
+                runtimeError(&call, "range(): step non può essere 0");
+                return ArrayValue{};
+            }
+        }
+    }
+
+    // Range lazy: gli elementi sono calcolati alla lettura
+    long long span = step > 0 ? static_cast<long long>(end) - start
+                              : static_cast<long long>(start) - end;
+    long long stride = step > 0 ? step : -static_cast<long long>(step);
+
+    IntRange range;
+    range.start = start;
+    range.step = step;
+    range.count = span > 0 ? static_cast<size_t>((span + stride - 1) / stride) : 0;
+    return ArrayValue(range);
 }
 
 // =======================
 // Funzioni utente
 // =======================
 
+// Risoluzione di una Call per nome. Ordine (come Interpreter::lookup()):
+// 1. Variabili (incluse quelle con FunctionValue)
+// 2. Def locali e globali senza variabile omonima: destinazione dalla
+//    cache della Call, catture dallo scope corrente
+// 3. Builtin
+// 4. Def locali (nested), poi globali
+Interpreter::PreparedCall Interpreter::prepareCall(const ASTNode& node) {
+    // Builtin che nessuna variabile o def può nascondere
+    if (node.builtinOnly) return prepareBuiltin(node);
+
+    PreparedCall call;
+    StoredVar* var = findVar(node);
+
+    if (var && isType<FunctionValue>(var->value)) {
+        call.kind = PreparedCall::Kind::FirstClass;
+        call.value = var->value;
+        return call;
+    }
+
+    if (!var) {
+        Value fn = callTargetOf(node);
+        if (isType<FunctionValue>(fn)) {
+            call.kind = PreparedCall::Kind::Def;
+            call.captured = captureFor(as<FunctionValue>(fn).body);
+            call.value = std::move(fn);
+            return call;
+        }
+    }
+
+    if (node.builtin >= 0) return prepareBuiltin(node);
+
+    call.def = currentScope().lookupLocalFunction(node.sym);
+    if (!call.def) {
+        auto it = functions.find(node.sym);
+        if (it == functions.end()) {
+            runtimeError(&node, "Funzione '" + node.value + "' non definita");
+            call.value = 0;
+            return call;
+        }
+        call.def = it->second;
+    }
+    call.kind = PreparedCall::Kind::UserDef;
+    return call;
+}
+
+// Builtin con argomenti valori e arità corretta: gli argomenti li valuta
+// il chiamante; altrimenti (arità errata, argomenti Raw) il builtin è
+// eseguito subito
+Interpreter::PreparedCall Interpreter::prepareBuiltin(const ASTNode& node) {
+    PreparedCall call;
+    const Builtin& b = builtins[node.builtin];
+    int argc = static_cast<int>(node.children.size());
+    if (b.args == BuiltinArgs::Values && argc >= b.minArgs &&
+        (b.maxArgs < 0 || argc <= b.maxArgs)) {
+        call.kind = PreparedCall::Kind::Builtin;
+        return call;
+    }
+    call.value = callBuiltin(node);
+    return call;
+}
+
+Value Interpreter::finishCall(PreparedCall& call, std::vector<Value> args, const ASTNode& node) {
+    switch (call.kind) {
+        case PreparedCall::Kind::Done:
+            return std::move(call.value);
+
+        case PreparedCall::Kind::Builtin:
+            DEBUG_INTERP_LOG("builtin " << builtinName(node.builtin) << "(), argc=" << args.size());
+            return (this->*builtins[node.builtin].fn)(node, args);
+
+        case PreparedCall::Kind::UserDef:
+            return callUserFunction(call.def, std::move(args), &node);
+
+        case PreparedCall::Kind::FirstClass:
+        case PreparedCall::Kind::Def:
+            break;
+    }
+
+    const FunctionValue& fv = as<FunctionValue>(call.value);
+    if (args.size() != fv.params.size()) {
+        runtimeError(&node, "Numero argomenti errato per funzione first-class");
+        return 0;
+    }
+
+    if (call.kind == PreparedCall::Kind::FirstClass)
+        return callFunctionValue(call.value, std::move(args), &node);
+
+    if (fv.body && fv.body->memo >= 0 && memoEnabled)
+        return invokeMemo(fv.body->memo,
+                          {nullptr, call.value, fv.body, std::move(args), std::move(call.captured)},
+                          &node);
+
+    return invoke({nullptr, call.value, fv.body, std::move(args), std::move(call.captured)},
+                  &node);
+}
+
 Value Interpreter::callUserFunction(const std::shared_ptr<ASTNode>& funcNode,
-                                    const ArrayValue& args,
+                                    std::vector<Value> args,
                                     const ASTNode* callSite)
 {
     size_t paramCount = 0;
     while (paramCount < funcNode->children.size() &&
-           funcNode->children[paramCount]->type == "Param") {
+           funcNode->children[paramCount]->kind == NodeKind::Param) {
         ++paramCount;
     }
 
@@ -1999,39 +2226,232 @@ Value Interpreter::callUserFunction(const std::shared_ptr<ASTNode>& funcNode,
     }
 
     if (paramCount >= funcNode->children.size() ||
-        funcNode->children[paramCount]->type != "Body") {
+        funcNode->children[paramCount]->kind != NodeKind::Body) {
         runtimeError(funcNode.get(), "FunctionDef senza Body");
         return 0;
     }
 
-    auto body = funcNode->children[paramCount];
+    return invoke({funcNode, Value(), funcNode->children[paramCount], std::move(args), nullptr},
+                  callSite);
+}
+
+// Funzione first-class (argomenti già controllati)
+Value Interpreter::callFunctionValue(const Value& fn,
+                                     std::vector<Value> args,
+                                     const ASTNode* callSite)
+{
+    const FunctionValue& fv = as<FunctionValue>(fn);
+
+    // ============================================
+    // FUNZIONE COMPOSTA: f $ g
+    // ============================================
+    if (!fv.composedFuncs.empty()) {
+        // Esegui composizione: (f $ g)(x) = g(f(x))
+        Value result = args[0];  // Valore iniziale
 
-    pushScope();
+        // Applica ogni funzione in sequenza
+        for (auto& funcPtr : fv.composedFuncs) {
+            const FunctionValue& func = *funcPtr;
 
-    for (size_t i = 0; i < paramCount; ++i) {
-        auto p = funcNode->children[i];
-        std::string pname = p->value;
+            // Crea scope temporaneo
+            pushScope(func.body ? func.body->frame.get() : nullptr);
 
-        if (!args[i]) {
-            defineVar(pname, 0, true);
-        } else {
-            defineVar(pname, *args[i], true);
+            // Ripristina variabili catturate
+            bindCaptured(func.capturedVars);
+
+            // Bind parametro
+            defineVar(func.params[0], result, false, false);
+
+            // Esegui funzione
+            result = runBody(func.body);
+
+            popScope();
         }
+
+        return result;
+    }
+
+    // ============================================
+    // FUNZIONE NORMALE
+    // ============================================
+    return invoke({nullptr, fn, fv.body, std::move(args), fv.capturedVars}, callSite);
+}
+
+// ============================================================
+// invoke - Esegue una chiamata con il trampolino delle tail call
+// ============================================================
+Value Interpreter::invoke(TailCall call, const ASTNode* callSite) {
+    // In coda al body di un invoke() attivo: la esegue il suo trampolino
+    if (callSite && callSite->tail && canDeferTail(call)) {
+        pendingTail = std::move(call);
+        tailPending = true;
+        return 0;
     }
 
-    Value ret = eval(body);
+    pushScope(call.body ? call.body->frame.get() : nullptr);
+    size_t savedFrame = tailFrame;
+    tailFrame = scopes.size();
+
+    bool zero = false;
+    Value ret;
+    while (true) {
+        enterFrame(call);
+
+        // Se una funzione della catena ritorna zero, la chiamata ritorna 0
+        if (call.def && call.def->extra.count("returnType") &&
+            call.def->extra.at("returnType") == "zero")
+            zero = true;
+
+        ret = runBody(call.body);
+        if (!tailPending) break;
+
+        // Prossima iterazione: stessa funzione → stesso scope così com'è
+        // (equivale al frame chiamato, che vedrebbe quello del chiamante);
+        // altra funzione → lo scope riparte con il suo layout
+        tailPending = false;
+        auto prevBody = std::move(call.body);
+        call = std::move(pendingTail);
+        if (call.body != prevBody) {
+            Scope& s = currentScope();
+            Scope* parent = s.parent;
+            if (!s.localFunctions.empty()) invalidateCallCaches();
+            s.release();
+            s.reset(parent, call.body->frame.get());
+        }
+    }
 
+    tailFrame = savedFrame;
     popScope();
 
-    // Se funzione ritorna zero, ignora ret e ritorna sempre 0
-    std::string retType = funcNode->extra.count("returnType")
-                          ? funcNode->extra.at("returnType")
-                          : "";
-    if (retType == "zero") {
-        return 0;
+    return zero ? Value(0) : ret;
+}
+
+// ============================================================
+// Memo delle def pure ricorsive
+// ============================================================
+
+// Identità esatta dei valori: stesso tipo e stesso contenuto
+// (3 e 3.0, 0.0 e -0.0 restano chiavi distinte)
+static uint64_t doubleBits(double d) {
+    uint64_t bits;
+    std::memcpy(&bits, &d, sizeof bits);
+    return bits;
+}
+
+static size_t hashValue(const Value& v) {
+    switch (v.tag) {
+        case Value::Tag::Int:    return std::hash<int>{}(as<int>(v));
+        case Value::Tag::Double: return std::hash<uint64_t>{}(doubleBits(as<double>(v)));
+        case Value::Tag::String: return std::hash<std::string>{}(as<std::string>(v));
+        default: return 0;
     }
+}
 
-    return ret;
+static bool sameValue(const Value& a, const Value& b) {
+    if (a.tag != b.tag) return false;
+    switch (a.tag) {
+        case Value::Tag::Int:    return as<int>(a) == as<int>(b);
+        case Value::Tag::Double: return doubleBits(as<double>(a)) == doubleBits(as<double>(b));
+        case Value::Tag::String: return as<std::string>(a) == as<std::string>(b);
+        default: return false;
+    }
+}
+
+// Solo argomenti scalari: le funzioni non hanno un'identità confrontabile,
+// e per gli array hash e confronto costerebbero una visita completa ad
+// ogni chiamata (quadratico sulle def che scorrono un array) oltre a
+// tenere vivi gli array nella tabella
+static bool memoizable(const Value& v) {
+    return v.tag != Value::Tag::Function && v.tag != Value::Tag::Array;
+}
+
+size_t Interpreter::MemoHash::operator()(const std::vector<Value>& args) const {
+    size_t h = args.size();
+    for (const auto& v : args) h = h * 1000003 ^ hashValue(v);
+    return h;
+}
+
+bool Interpreter::MemoEq::operator()(const std::vector<Value>& a,
+                                     const std::vector<Value>& b) const {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i)
+        if (!sameValue(a[i], b[i])) return false;
+    return true;
+}
+
+Value Interpreter::invokeMemo(int table, TailCall call, const ASTNode* callSite) {
+    for (const auto& v : call.args)
+        if (!memoizable(v)) return invoke(std::move(call), callSite);
+
+    if (memoTables.size() <= static_cast<size_t>(table))
+        memoTables.resize(table + 1);
+
+    auto it = memoTables[table].find(call.args);
+    if (it != memoTables[table].end()) {
+        ++memoHits;
+        return it->second;
+    }
+    ++memoMisses;
+
+    std::vector<Value> key = call.args;
+    size_t errorsBefore = errorCount;
+    Value result = invoke(std::move(call), callSite);
+
+    // Rinviata al trampolino (valore non ancora noto) o con errori: non si memorizza
+    if (tailPending || errorCount != errorsBefore) return result;
+
+    // La tabella può essere stata riallocata dalle chiamate annidate
+    MemoTable& entries = memoTables[table];
+    if (entries.size() >= MEMO_CAPACITY) {
+        entries.clear();
+        ++memoEvictions;
+    }
+    entries.emplace(std::move(key), result);
+    return result;
+}
+
+void Interpreter::printMemoStats(std::ostream& out) const {
+    size_t entries = 0;
+    for (const auto& t : memoTables) entries += t.size();
+    out << "Memo: " << memoHits << " hit, " << memoMisses << " miss, "
+        << entries << " voci, " << memoEvictions << " svuotamenti\n";
+}
+
+bool Interpreter::canDeferTail(const TailCall& call) {
+    if (tailFrame != scopes.size() || !call.body || !call.body->frame)
+        return false;
+
+    Scope& caller = currentScope();
+    const FrameLayout& callee = *call.body->frame;
+    if (caller.layout == &callee) return true;
+
+    // Altra funzione: lo scope del chiamante viene sostituito, quindi
+    // (scope dinamici) la chiamata non deve vederne né variabili né
+    // funzioni locali
+    for (int slot : callee.captures) {
+        Symbol name = callee.names[slot];
+        if (caller.findLocal(name) || caller.localFunctions.count(name))
+            return false;
+    }
+    return true;
+}
+
+// Parametri (e catture per le first-class) nello scope della chiamata
+void Interpreter::enterFrame(const TailCall& call) {
+    if (call.def) {
+        for (size_t i = 0; i < call.args.size(); ++i)
+            defineVar(call.def->children[i]->sym, call.args[i], true);
+        return;
+    }
+
+    const FunctionValue& fv = as<FunctionValue>(call.fn);
+
+    // Ripristina variabili catturate (closure)
+    bindCaptured(call.captured);
+
+    // Bind parametri (possono sovrascrivere variabili catturate)
+    for (size_t i = 0; i < fv.params.size(); ++i)
+        defineVar(fv.params[i], call.args[i], false, false);
 }
 
 // ============================================================
@@ -2047,21 +2467,22 @@ Value Interpreter::evalAssignment(const std::shared_ptr<ASTNode>& node) {
     auto valueExpr = node->children[1];
 
     // Caso 1: Assegnamento variabile semplice
-    if (target->type == "Identifier") {
-        std::string varName = target->value;
+    if (target->kind == NodeKind::Identifier) {
+        if (node->append > 0) return evalAppend(node);
+
         Value newVal = eval(valueExpr);
-        setVar(varName, newVal);
+        setVarAt(*target, newVal);
         return newVal;
     }
 
     // Caso 2: Assegnamento array element arr[idx] = val
-    if (target->type == "ArrayAccess") {
+    if (target->kind == NodeKind::ArrayAccess) {
         if (target->children.size() < 2) {
             runtimeError(target.get(), "ArrayAccess malformato");
             return 0;
         }
 
-        std::string arrName = target->value;
+        const std::string& arrName = target->value;
         auto idxNode = target->children[0];
 
         // Valuta indice
@@ -2073,7 +2494,7 @@ Value Interpreter::evalAssignment(const std::shared_ptr<ASTNode>& node) {
         int idx = as<int>(idxVal);
 
         // Lookup array
-        auto sv = currentScope().lookup(arrName);
+        auto sv = findVar(*target);
         if (!sv) {
             runtimeError(target.get(), "Array '" + arrName + "' non definito");
             return 0;
@@ -2105,7 +2526,7 @@ Value Interpreter::evalAssignment(const std::shared_ptr<ASTNode>& node) {
 
         // Valuta e assegna
         Value newVal = eval(valueExpr);
-        *arr[normIdx] = newVal;
+        arr.set(normIdx, newVal);
         return newVal;
     }
 
@@ -2113,3 +2534,62 @@ Value Interpreter::evalAssignment(const std::shared_ptr<ASTNode>& node) {
     return 0;
 }
 
+// ============================================================
+// evalAppend - s = s $ a $ b ... senza ricopiare s
+// ============================================================
+Value Interpreter::evalAppend(const std::shared_ptr<ASTNode>& node) {
+    const auto& target = node->children[0];
+    const auto& chain = node->children[1];
+
+    const ASTNode* leaf = chain.get();
+    for (int i = 0; i < node->append; ++i) leaf = leaf->children[0].get();
+
+    // s non è (ancora) una stringa: assegnamento normale
+    StoredVar* sv = findVar(*leaf);
+    if (!sv || !isType<std::string>(sv->value)) {
+        Value newVal = eval(chain);
+        setVarAt(*target, newVal);
+        return newVal;
+    }
+
+    AppendState st;
+    st.old = sv->value;
+    evalAppendPieces(*chain, node->append, st);
+
+    if (st.generic) {
+        setVarAt(*target, st.acc);
+        return st.acc;
+    }
+
+    // Nessun pezzo ha riassegnato s: la sua stringa cresce in place
+    // (as<> la ricopia solo se è condivisa con un'altra variabile)
+    StoredVar* dst = findVar(*target);
+    if (dst && !dst->isFixed && isType<std::string>(dst->value) &&
+        dst->value.box == st.old.box) {
+        st.old = Value();
+        as<std::string>(dst->value) += st.tail;
+        return dst->value;
+    }
+
+    Value newVal = as<std::string>(st.old) + st.tail;
+    setVarAt(*target, newVal);
+    return newVal;
+}
+
+// Valuta i pezzi di Concat(Concat(s, a), b) da sinistra, come eval della catena
+void Interpreter::evalAppendPieces(const ASTNode& link, int pieces, AppendState& st) {
+    if (pieces > 1) evalAppendPieces(*link.children[0], pieces - 1, st);
+
+    Value piece = eval(link.children[1]);
+    if (!st.generic) {
+        if (isType<std::string>(piece)) {
+            st.tail += as<std::string>(piece);
+            return;
+        }
+        // Pezzo non stringa: da qui la catena prosegue come evalBinaryOp
+        st.acc = as<std::string>(st.old) + st.tail;
+        st.generic = true;
+    }
+    st.acc = evalBinaryOp(Operator::Concat, st.acc, piece, &link);
+}
+
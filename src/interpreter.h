@@ -5,38 +5,99 @@
 #include <vector>
 #include <unordered_map>
 #include <memory>
+#include <iostream>
 
 #include "ast.h"
 #include "value.h"
 #include "scope.h"
 #include "range.h"
+#include "builtins.h"
+
+class VM;
+class ThreadPool;
 
 class Interpreter {
+    friend class VM;
+
 public:
     Interpreter();
     ~Interpreter();
 
     Value eval(const std::shared_ptr<ASTNode>& node);
 
+    // Thread per i filter con predicato puro (--threads, 1 = sequenziale):
+    // il pool è creato qui, una volta sola
+    void setThreads(unsigned n);
+
+    // Sotto questa dimensione un filter resta sequenziale
+    static constexpr size_t PARALLEL_FILTER_MIN = 100000;
+
+    // Memo delle def pure ricorsive (--no-memo per disattivarla)
+    void setMemo(bool on) { memoEnabled = on; }
+    void printMemoStats(std::ostream& out) const;
+
+    // Voci massime per tabella: oltre, la tabella viene svuotata
+    static constexpr size_t MEMO_CAPACITY = 65536;
+
 private:
+    // Worker di un filter parallelo: vede gli scope di owner in sola
+    // lettura (non ne è proprietario) e raccoglie i propri errori.
+    // I worker restano vivi tra un filter e l'altro: borrowScopes
+    // li riallinea agli scope e alle funzioni correnti di owner.
+    explicit Interpreter(const Interpreter& owner);
+    void borrowScopes(const Interpreter& owner);
+    size_t borrowedScopes = 0;      // scopes[0..borrowedScopes) appartengono a owner
+    unsigned threads = 1;
+    std::ostream* errors = &std::cerr;
+    std::unique_ptr<ThreadPool> filterPool;
+    std::vector<std::unique_ptr<Interpreter>> filterWorkers;
+
+    // Engine bytecode opzionale (--engine=vm): se presente esegue i body delle funzioni
+    VM* vm = nullptr;
+    Value runBody(const std::shared_ptr<ASTNode>& body);
+
+    // Statement di un Body
+    void execStatement(const std::shared_ptr<ASTNode>& st, Value& last);
+
     // Scopes
     std::vector<Scope*> scopes;
+    std::vector<Scope*> freeScopes;   // pool di scope già allocati
     Scope& currentScope();
-    void pushScope();
+    void pushScope(const FrameLayout* layout = nullptr);
+    void enterProgram(const ASTNode& program);
     void popScope();
 
-    // Variabili
-    Value lookup(const std::string& name);
-    void defineVar(const std::string& name, const Value& v, bool isDynamic = false, bool isFixed = false);
-    void setVar(const std::string& name, const Value& v);
+    // Variabili (per simbolo, symbols.h)
+    Value lookup(Symbol name);
+    void defineVar(Symbol name, const Value& v, bool isDynamic = false, bool isFixed = false);
+    void setVar(Symbol name, const Value& v);
+    void assignStored(StoredVar& sv, Symbol name, const Value& v);
+
+    // Variabile implicita dei predicati di filter
+    const Symbol filterItem = internSymbol("x");
+
+    // Variabili nominate da un nodo: usano (depth, slot) del Resolver
+    // e ricadono sul lookup per nome se lo slot non è definito
+    StoredVar* findVar(const ASTNode& ref);
+    Value lookupVar(const ASTNode& ref);
+    void defineVarAt(const ASTNode& decl, const Value& v, bool isDynamic = false, bool isFixed = false);
+    void setVarAt(const ASTNode& ref, const Value& v);
+
+    // Closure: ambiente delle variabili libere di un body
+    std::shared_ptr<const CapturedEnv> captureFor(const std::shared_ptr<ASTNode>& body);
+    void bindCaptured(const std::shared_ptr<const CapturedEnv>& env);
 
     // Semantica
     bool isTruthy(const Value& v) const;
     std::string toString(const Value& v) const;
 
+    // == / != : confronto delle forme testuali, senza costruirle
+    bool valuesEqual(const Value& a, const Value& b) const;
+    bool arraysEqual(const Value& a, const Value& b) const;
+
     // ⭐ Range e slicing
     RangeInfo parseRangeNode(const std::shared_ptr<ASTNode>& node);
-    Value sliceString(const std::string& s,
+    Value sliceString(const Value& str,
                       const RangeInfo& range,
                       const ASTNode* node);
     Value sliceArray(const ArrayValue& arr,
@@ -46,32 +107,160 @@ private:
     // Assignment
     Value evalAssignment(const std::shared_ptr<ASTNode>& node);
 
-    // Operatori
-    Value evalBinaryOp(const std::string& op,
-                       Value left,
-                       Value right,
+    // s = s $ a $ b ... (ASTNode::append): i pezzi stringa sono raccolti
+    // in 'tail' e aggiunti in place; un pezzo non stringa fa proseguire
+    // la catena in 'acc' come evalBinaryOp
+    struct AppendState {
+        Value old;          // stringa di s letta prima dei pezzi
+        std::string tail;
+        Value acc;
+        bool generic = false;
+    };
+    Value evalAppend(const std::shared_ptr<ASTNode>& node);
+    void evalAppendPieces(const ASTNode& link, int pieces, AppendState& st);
+
+    // Operatori (id legato dal parser, ASTNode::op)
+    Value evalBinaryOp(Operator op,
+                       const Value& left,
+                       const Value& right,
                        const ASTNode* node);
 
-    Value evalUnaryOp(const std::string& op,
+    Value evalUnaryOp(Operator op,
                       const Value& val,
                       const ASTNode* node);
 
+    // Operatore $ (stringhe, array, composizione di funzioni)
+    Value evalConcat(const Value& left,
+                     const Value& right,
+                     const ASTNode* node);
+
+    // arr[i] con indice già valutato (ArrayAccess e VM)
+    Value indexValue(const Value& arrayVal, const Value& idxV, const ASTNode* node);
+
     // CondChain / Elvis / Filter
     Value evalCondChain(const std::shared_ptr<ASTNode>& node);
     Value evalElvis(const std::shared_ptr<ASTNode>& node);
     Value evalFilter(const std::shared_ptr<ASTNode>& node);
 
+    // Stadi fusi di una catena di filter sugli elementi [begin, end)
+    void filterRange(const std::vector<const ASTNode*>& stages,
+                     const ArrayValue& input,
+                     size_t begin, size_t end,
+                     ArrayValue& out);
+
+    // ⭐ Builtin: tabella indicizzata per BuiltinId (legato dal parser)
+    enum class BuiltinArgs {
+        Values,     // argomenti valutati prima della chiamata
+        Raw         // il builtin legge i nodi argomento (es. nome dell'array)
+    };
+    using BuiltinFn = Value (Interpreter::*)(const ASTNode& call, std::vector<Value>& args);
+    struct Builtin {
+        int minArgs;
+        int maxArgs;                // < 0: qualsiasi numero
+        BuiltinArgs args;
+        BuiltinFn fn;
+        Value::Tag errorTag;        // tipo del valore restituito se l'arità è errata
+        const char* arityError;
+    };
+    static const Builtin builtins[];
+
+    Value callBuiltin(const ASTNode& call);
+    Value builtinStr(const ASTNode& call, std::vector<Value>& args);
+    Value builtinLen(const ASTNode& call, std::vector<Value>& args);
+    Value builtinRandInt(const ASTNode& call, std::vector<Value>& args);
+    Value builtinRandDouble(const ASTNode& call, std::vector<Value>& args);
+    Value builtinArrayPush(const ASTNode& call, std::vector<Value>& args);
+    Value builtinArrayPop(const ASTNode& call, std::vector<Value>& args);
+    Value builtinArrayLength(const ASTNode& call, std::vector<Value>& args);
+    Value builtinArrayFirst(const ASTNode& call, std::vector<Value>& args);
+    Value builtinArrayLast(const ASTNode& call, std::vector<Value>& args);
+    Value builtinToInt(const ASTNode& call, std::vector<Value>& args);
+    Value builtinToDouble(const ASTNode& call, std::vector<Value>& args);
+    Value builtinTypeOf(const ASTNode& call, std::vector<Value>& args);
+    Value builtinInput(const ASTNode& call, std::vector<Value>& args);
+    Value builtinRange(const ASTNode& call, std::vector<Value>& args);
+
+    // Chiamata per nome in due passi, come nel case Call di eval():
+    // prepareCall risolve la destinazione (e le catture) prima degli
+    // argomenti, finishCall la esegue con gli argomenti valutati.
+    // Done: niente argomenti da valutare, value è già il risultato.
+    struct PreparedCall {
+        enum class Kind { Done, Builtin, FirstClass, Def, UserDef };
+        Kind kind = Kind::Done;
+        Value value;                                    // funzione o risultato (Done)
+        std::shared_ptr<ASTNode> def;                   // UserDef
+        std::shared_ptr<const CapturedEnv> captured;    // Def
+    };
+    PreparedCall prepareCall(const ASTNode& node);
+    PreparedCall prepareBuiltin(const ASTNode& node);
+    Value finishCall(PreparedCall& call, std::vector<Value> args, const ASTNode& node);
+
     // Funzioni utente
     Value callUserFunction(const std::shared_ptr<ASTNode>& funcNode,
-                           const ArrayValue& args,
+                           std::vector<Value> args,
                            const ASTNode* callSite);
+    Value callFunctionValue(const Value& fn,
+                            std::vector<Value> args,
+                            const ASTNode* callSite);
+
+    // Chiamata già validata: funzione def (FunctionDef) o first-class
+    struct TailCall {
+        std::shared_ptr<ASTNode> def;   // FunctionDef, oppure nullptr...
+        Value fn;                       // ...e allora FunctionValue
+        std::shared_ptr<ASTNode> body;
+        std::vector<Value> args;
+        std::shared_ptr<const CapturedEnv> captured;   // solo first-class
+    };
+
+    // ⭐ Tail call (TCO): una chiamata marcata 'tail' dal Resolver non
+    // ricorre in C++ ma resta in pendingTail; il trampolino di invoke()
+    // la esegue riusando lo scope del chiamante
+    TailCall pendingTail;
+    bool tailPending = false;
+    size_t tailFrame = 0;   // profondità dello scope dell'invoke() più interno
+
+    Value invoke(TailCall call, const ASTNode* callSite);
+    bool canDeferTail(const TailCall& call);
+    void enterFrame(const TailCall& call);
+
+    // ⭐ Cache di chiamata: ogni Call per nome (ASTNode::callSite) ricorda
+    // la def risolta. callEpoch cambia quando cambiano le funzioni locali
+    // visibili (nuova definizione o scope che le conteneva rimosso)
+    struct CallCache {
+        uint64_t epoch = 0;
+        Value target;       // FunctionValue della def (senza catture), 0 = nessuna def
+    };
+    std::vector<CallCache> callCaches;
+    uint64_t callEpoch = 1;
+    void invalidateCallCaches() { ++callEpoch; }
+    Value callTargetOf(const ASTNode& call);
+    FunctionValue functionValueOf(const std::shared_ptr<ASTNode>& def);
+
+    // ⭐ Memo delle def pure ricorsive (ASTNode::memo, dal Resolver):
+    // risultato per argomenti scalari identici (stesso tipo e valore esatto).
+    // Una chiamata che ha segnalato errori non viene memorizzata, così
+    // i messaggi si ripetono come senza memo.
+    struct MemoHash {
+        size_t operator()(const std::vector<Value>& args) const;
+    };
+    struct MemoEq {
+        bool operator()(const std::vector<Value>& a, const std::vector<Value>& b) const;
+    };
+    using MemoTable = std::unordered_map<std::vector<Value>, Value, MemoHash, MemoEq>;
+    std::vector<MemoTable> memoTables;
+    bool memoEnabled = true;
+    size_t memoHits = 0;
+    size_t memoMisses = 0;
+    size_t memoEvictions = 0;
+    mutable size_t errorCount = 0;      // errori segnalati (runtimeError)
+    Value invokeMemo(int table, TailCall call, const ASTNode* callSite);
 
     // Utility
     void runtimeError(const ASTNode* node, const std::string& msg) const;
     void printValue(const Value& v) const;
 
     // Tabella funzioni
-    std::unordered_map<std::string, std::shared_ptr<ASTNode>> functions;
+    std::unordered_map<Symbol, std::shared_ptr<ASTNode>> functions;
 };
 
 #endif // MAMMUTH_INTERPRETER_H
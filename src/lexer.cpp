@@ -64,15 +64,23 @@ bool Lexer::match(char expected) {
     return true;
 }
 
+// Spazi su una stessa riga: nessun newline, avanza solo la colonna
 void Lexer::skipWhitespace() {
-    while (isspace(peek()) && peek() != '\n')
-        advance();
+    size_t start = pos;
+    while (pos < source.size()) {
+        char c = source[pos];
+        if (c != ' ' && c != '\t' && c != '\r' && c != '\v' && c != '\f') break;
+        ++pos;
+    }
+    column += static_cast<int>(pos - start);
 }
 
 void Lexer::skipComment() {
-    // Single-line comment: # resto della linea
-    while (peek() != '\n' && peek() != '\0')
-        advance();
+    // Single-line comment: # resto della linea (il newline resta un token)
+    size_t start = pos;
+    while (pos < source.size() && source[pos] != '\n' && source[pos] != '\0')
+        ++pos;
+    column += static_cast<int>(pos - start);
 }
 
 void Lexer::skipMultiLineComment() {
@@ -100,8 +108,14 @@ void Lexer::skipMultiLineComment() {
     }
 }
 
-Token Lexer::makeToken(TokenType type, const std::string& lexeme) {
-    return {type, lexeme, line, column};
+Token Lexer::makeToken(TokenType type, std::string_view lexeme) {
+    Token t{type, NO_SYMBOL, lexeme, line, column};
+
+    // Solo gli identificatori entrano nella tabella dei simboli: il
+    // testo dei letterali resta nel lessema (la tabella non si svuota)
+    if (type == TokenType::IDENT)
+        t.sym = symbols->intern(lexeme);
+    return t;
 }
 
 
@@ -109,8 +123,26 @@ Token Lexer::makeToken(TokenType type, const std::string& lexeme) {
 // STRINGHE
 // ============================================================
 Token Lexer::stringLiteral() {
-    std::string value;
     int startLine = line, startColumn = column;
+    size_t start = pos;
+
+    // Senza escape il lessema è il testo tra le virgolette nel sorgente
+    while (pos < source.size()) {
+        char c = source[pos];
+        if (c == '"' || c == '\\' || c == '\0') break;
+        if (c == '\n') { line++; column = 1; }
+        else column++;
+        ++pos;
+    }
+
+    if (peek() == '"') {
+        std::string_view text(source.data() + start, pos - start);
+        advance(); // chiude stringa
+        return makeToken(TokenType::STRING, text);
+    }
+
+    // Con escape: il testo decodificato vive nell'arena del Lexer
+    std::string& value = decoded.emplace_back(source, start, pos - start);
 
     while (peek() != '"' && peek() != '\0') {
 
@@ -161,13 +193,16 @@ Token Lexer::stringLiteral() {
         se è "." + NON-cifra → double malformato
 */
 Token Lexer::numberLiteral() {
-    std::string num;
     int startLine   = line;
     int startColumn = column;
+    size_t start    = pos;
+
+    // Il lessema è la porzione di sorgente consumata fin qui
+    auto num = [&] { return std::string_view(source.data() + start, pos - start); };
 
     // 1) Consuma tutte le cifre iniziali
     while (isdigit(peek())) {
-        num += advance();
+        advance();
     }
 
     // 2) Se il prossimo è '.', può essere:
@@ -179,67 +214,120 @@ Token Lexer::numberLiteral() {
         // ⭐ Se è "..", NON fa parte del numero
         if (pos + 1 < source.size() && source[pos + 1] == '.') {
             // Il numero termina qui: INT
-            return makeToken(TokenType::NUMBER_INT, num);
+            return makeToken(TokenType::NUMBER_INT, num());
         }
 
         // Caso double: numero + "." + cifra?
         advance();
-        num += '.';
 
         if (!isdigit(peek())) {
             // Caso "3." isolato → errore ma accettato come DOUBLE
             lexerError(startLine, startColumn,
                        "Numero malformato: termina con punto decimale.");
-            return makeToken(TokenType::NUMBER_DBL, num);
+            return makeToken(TokenType::NUMBER_DBL, num());
         }
 
         // Consuma le cifre dopo il punto
         while (isdigit(peek())) {
-            num += advance();
+            advance();
         }
 
-        return makeToken(TokenType::NUMBER_DBL, num);
+        return makeToken(TokenType::NUMBER_DBL, num());
     }
 
     // Nessun punto → INT
-    return makeToken(TokenType::NUMBER_INT, num);
+    return makeToken(TokenType::NUMBER_INT, num());
 }
 
 
 // ============================================================
 // IDENTIFICATORI + KEYWORDS
 // ============================================================
+/*
+   Parole chiave riconosciute con un hash perfetto: lunghezza,
+   primo e ultimo carattere danno un indice distinto per ogni
+   keyword in una tabella di 64 posti; un solo confronto col
+   testo della keyword candidata decide.
+*/
+namespace {
+
+struct Keyword {
+    std::string_view text;
+    TokenType type;
+};
+
+constexpr Keyword keywords[] = {
+    {"fixed",    TokenType::KW_FIXED},
+    {"dynamic",  TokenType::KW_DYNAMIC},
+    {"int",      TokenType::KW_INT},
+    {"double",   TokenType::KW_DOUBLE},
+    {"string",   TokenType::KW_STRING},
+    {"zero",     TokenType::KW_ZERO},
+    {"def",      TokenType::KW_DEF},
+    {"if",       TokenType::KW_IF},
+    {"elif",     TokenType::KW_ELIF},
+    {"else",     TokenType::KW_ELSE},
+    {"for",      TokenType::KW_FOR},
+    {"in",       TokenType::KW_IN},
+    {"while",    TokenType::KW_WHILE},
+    {"do",       TokenType::KW_DO},
+    {"end",      TokenType::KW_END},
+    {"echo",     TokenType::KW_ECHO},
+    {"err",      TokenType::KW_ERR},
+    {"break",    TokenType::KW_BREAK},
+    {"continue", TokenType::KW_CONTINUE},
+    {"and",      TokenType::AND},
+    {"or",       TokenType::OR},
+    {"not",      TokenType::NOT},
+};
+
+constexpr size_t KEYWORD_COUNT = sizeof(keywords) / sizeof(keywords[0]);
+constexpr size_t KEYWORD_MIN = 2;
+constexpr size_t KEYWORD_MAX = 8;
+constexpr size_t KEYWORD_SLOTS = 64;
+
+constexpr size_t keywordHash(std::string_view id) {
+    return (id.size() + static_cast<unsigned char>(id.front()) +
+            12 * static_cast<unsigned char>(id.back())) % KEYWORD_SLOTS;
+}
+
+// slot → indice in keywords (-1 = nessuna keyword)
+struct KeywordTable {
+    int8_t slot[KEYWORD_SLOTS] = {};
+    bool perfect = true;
+
+    constexpr KeywordTable() {
+        for (auto& s : slot) s = -1;
+        for (size_t i = 0; i < KEYWORD_COUNT; ++i) {
+            size_t h = keywordHash(keywords[i].text);
+            if (slot[h] >= 0) perfect = false;
+            slot[h] = static_cast<int8_t>(i);
+        }
+    }
+};
+
+constexpr KeywordTable keywordTable;
+static_assert(keywordTable.perfect, "collisione nell'hash delle keyword");
+
+TokenType keywordType(std::string_view id) {
+    if (id.size() < KEYWORD_MIN || id.size() > KEYWORD_MAX) return TokenType::IDENT;
+    int k = keywordTable.slot[keywordHash(id)];
+    return (k >= 0 && keywords[k].text == id) ? keywords[k].type : TokenType::IDENT;
+}
+
+} // namespace
+
 Token Lexer::identifier() {
-    std::string id;
-
-    while (isalnum(peek()) || peek() == '_')
-        id += advance();
-
-    // parole chiave Mammuth
-    if (id == "fixed")     return makeToken(TokenType::KW_FIXED, id);
-    if (id == "dynamic")   return makeToken(TokenType::KW_DYNAMIC, id);
-    if (id == "int")       return makeToken(TokenType::KW_INT, id);
-    if (id == "double")    return makeToken(TokenType::KW_DOUBLE, id);
-    if (id == "string")    return makeToken(TokenType::KW_STRING, id);
-    if (id == "zero")      return makeToken(TokenType::KW_ZERO, id);
-    if (id == "def")       return makeToken(TokenType::KW_DEF, id);
-    if (id == "if")        return makeToken(TokenType::KW_IF, id);
-    if (id == "elif")      return makeToken(TokenType::KW_ELIF, id);
-    if (id == "else")      return makeToken(TokenType::KW_ELSE, id);
-    if (id == "for")       return makeToken(TokenType::KW_FOR, id);
-    if (id == "in")        return makeToken(TokenType::KW_IN, id);
-    if (id == "while")     return makeToken(TokenType::KW_WHILE, id);
-    if (id == "do")        return makeToken(TokenType::KW_DO, id);
-    if (id == "end")       return makeToken(TokenType::KW_END, id);
-    if (id == "echo")      return makeToken(TokenType::KW_ECHO, id);
-    if (id == "err")       return makeToken(TokenType::KW_ERR, id);
-    if (id == "break")     return makeToken(TokenType::KW_BREAK, id);
-    if (id == "continue")  return makeToken(TokenType::KW_CONTINUE, id);
-    if (id == "and")       return makeToken(TokenType::AND, id);
-    if (id == "or")        return makeToken(TokenType::OR, id);
-    if (id == "not")       return makeToken(TokenType::NOT, id);
-
-    return makeToken(TokenType::IDENT, id);
+    size_t start = pos;
+
+    // Un identificatore non contiene newline: avanza direttamente
+    while (pos < source.size() && (isalnum(static_cast<unsigned char>(source[pos])) ||
+                                   source[pos] == '_'))
+        ++pos;
+    column += static_cast<int>(pos - start);
+
+    std::string_view id(source.data() + start, pos - start);
+    return makeToken(keywordType(id), id);
 }
 
 
@@ -248,7 +336,13 @@ Token Lexer::identifier() {
 // ============================================================
 std::vector<Token> Lexer::tokenize() {
 
+    // Un token ogni pochi byte: niente riallocazioni nel caso tipico
     std::vector<Token> tokens;
+    tokens.reserve(source.size() / 3 + 1);
+
+    // Simboli dei token: un solo lock della tabella per tutto il sorgente
+    SymbolBatch batch;
+    symbols = &batch;
 
     while (true) {
         skipWhitespace();
@@ -268,8 +362,7 @@ std::vector<Token> Lexer::tokenize() {
             
             // Single-line comment: # resto linea
             // Già consumato '#', skippa resto linea
-            while (peek() != '\n' && peek() != '\0')
-                advance();
+            skipComment();
             continue;
         }
 
@@ -419,6 +512,7 @@ std::vector<Token> Lexer::tokenize() {
     // EOF
     Token eof = makeToken(TokenType::END_OF_FILE, "EOF");
     tokens.push_back(eof);
+    symbols = nullptr;
 
 #if TOKEN_DUMP
     std::cout << "[TOKEN] EOF\n";
@@ -1,9 +1,13 @@
 #ifndef MAMMUTH_LEXER_H
 #define MAMMUTH_LEXER_H
 
+#include <deque>
 #include <string>
+#include <string_view>
 #include <vector>
 
+#include "symbols.h"
+
 enum class TokenType {
     // Fine file
     END_OF_FILE,
@@ -59,9 +63,13 @@ enum class TokenType {
     NEWLINE
 };
 
+// Il lessema è una vista sul sorgente posseduto dal Lexer (o sulla
+// sua arena per le stringhe con escape): i token restano validi
+// finché il Lexer che li ha prodotti è vivo
 struct Token {
     TokenType type;
-    std::string lexeme;
+    Symbol sym = NO_SYMBOL;     // solo identificatori (symbols.h)
+    std::string_view lexeme;
     int line;
     int column;
 };
@@ -71,8 +79,14 @@ public:
     explicit Lexer(const std::string& src);
     std::vector<Token> tokenize();
 
+    // I token puntano a source e decoded: il Lexer non si copia né si sposta
+    Lexer(const Lexer&) = delete;
+    Lexer& operator=(const Lexer&) = delete;
+
 private:
     std::string source;
+    std::deque<std::string> decoded;    // stringhe con escape, già decodificate
+    SymbolBatch* symbols = nullptr;     // tabella dei simboli durante tokenize()
     size_t pos = 0;
     int line = 1;
     int column = 1;
@@ -83,7 +97,7 @@ private:
     void skipWhitespace();
     void skipComment();
     void skipMultiLineComment();
-    Token makeToken(TokenType type, const std::string& lexeme);
+    Token makeToken(TokenType type, std::string_view lexeme);
     Token stringLiteral();
     Token numberLiteral();
     Token identifier();
@@ -2,7 +2,10 @@
 #include "lexer.h"
 #include "parser.h"
 #include "interpreter.h"
+#include "optimizer.h"
+#include "resolver.h"
 #include "transpiler_cpp.h"
+#include "vm.h"
 #include <iostream>
 #include <fstream>
 
@@ -32,6 +35,7 @@ int main(int argc, char* argv[]) {
 
         Parser parser(tokens);
         auto ast = parser.parseProgram();
+        if (driver.opts.optimize) Optimizer().optimize(ast);
 
         std::cout << "AST:\n";
         parser.printAST(ast);
@@ -48,6 +52,7 @@ int main(int argc, char* argv[]) {
         auto tokens = lexer.tokenize();
         Parser parser(tokens);
         auto ast = parser.parseProgram();
+        if (driver.opts.optimize) Optimizer().optimize(ast);
         CPPTranspiler cpptranspiler;
         std::string cpp_code = cpptranspiler.transpile(ast);
 
@@ -66,9 +71,23 @@ int main(int argc, char* argv[]) {
 
         Parser parser(tokens);
         auto ast = parser.parseProgram();
+        if (driver.opts.optimize) Optimizer().optimize(ast);
+
+        Resolver resolver;
+        resolver.resolve(ast);
 
         Interpreter interp;
-        interp.eval(ast);
+        interp.setThreads(driver.opts.threads);
+        interp.setMemo(driver.opts.memo);
+        if (driver.opts.engine == "vm") {
+            VM vm(interp);
+            vm.run(ast);
+        } else {
+            interp.eval(ast);
+        }
+
+        if (driver.opts.memo_stats)
+            interp.printMemoStats(std::cerr);
 
         return 0;
     }
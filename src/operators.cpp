@@ -0,0 +1,55 @@
+#include "operators.h"
+
+#include <unordered_map>
+
+Operator binaryOperator(const std::string& lexeme) {
+    static const std::unordered_map<std::string, Operator> index = {
+        {"+",   Operator::Add},
+        {"-",   Operator::Sub},
+        {"*",   Operator::Mul},
+        {"/",   Operator::Div},
+        {"%",   Operator::Mod},
+        {"**",  Operator::Pow},
+        {"<",   Operator::Lt},
+        {"<=",  Operator::Le},
+        {">",   Operator::Gt},
+        {">=",  Operator::Ge},
+        {"==",  Operator::Eq},
+        {"!=",  Operator::Ne},
+        {"and", Operator::And},
+        {"or",  Operator::Or},
+        {"$",   Operator::Concat},
+    };
+
+    auto it = index.find(lexeme);
+    return it != index.end() ? it->second : Operator::None;
+}
+
+Operator unaryOperator(const std::string& lexeme) {
+    if (lexeme == "-") return Operator::Neg;
+    if (lexeme == "!") return Operator::Not;
+    return Operator::None;
+}
+
+const char* operatorName(Operator op) {
+    switch (op) {
+        case Operator::Add:    return "+";
+        case Operator::Sub:    return "-";
+        case Operator::Mul:    return "*";
+        case Operator::Div:    return "/";
+        case Operator::Mod:    return "%";
+        case Operator::Pow:    return "**";
+        case Operator::Lt:     return "<";
+        case Operator::Le:     return "<=";
+        case Operator::Gt:     return ">";
+        case Operator::Ge:     return ">=";
+        case Operator::Eq:     return "==";
+        case Operator::Ne:     return "!=";
+        case Operator::And:    return "and";
+        case Operator::Or:     return "or";
+        case Operator::Concat: return "$";
+        case Operator::Neg:    return "-";
+        case Operator::Not:    return "!";
+        default:               return "";
+    }
+}
@@ -0,0 +1,42 @@
+#ifndef MAMMUTH_OPERATORS_H
+#define MAMMUTH_OPERATORS_H
+
+#include <cstdint>
+#include <string>
+
+// ============================================================
+// Operatori Mammuth: il parser lega ogni BinaryOp/LogicalOp/
+// UnaryOp al suo id (ASTNode::op), così Interpreter e VM fanno
+// dispatch con uno switch invece di confrontare stringhe.
+// None = operatore senza implementazione (es. & | ^ ~ << >> ?:),
+// segnalato a runtime con il lessema originale (ASTNode::value).
+// ============================================================
+enum class Operator : uint8_t {
+    None,
+
+    // Aritmetici
+    Add, Sub, Mul, Div, Mod, Pow,
+
+    // Confronti numerici
+    Lt, Le, Gt, Ge,
+
+    // Uguaglianza
+    Eq, Ne,
+
+    // Logici
+    And, Or,
+
+    // Concatenazione
+    Concat,
+
+    // Unari
+    Neg, Not
+};
+
+// Id dell'operatore binario/unario con questo lessema (None se non gestito)
+Operator binaryOperator(const std::string& lexeme);
+Operator unaryOperator(const std::string& lexeme);
+
+const char* operatorName(Operator op);
+
+#endif // MAMMUTH_OPERATORS_H
@@ -0,0 +1,440 @@
+#include "optimizer.h"
+#include "builtins.h"
+
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+// ============================================================
+// Literal
+// ============================================================
+static bool isLiteral(const std::shared_ptr<ASTNode>& node) {
+    return node && node->kind == NodeKind::Literal;
+}
+
+// Nuovo Literal con il valore 'v' nella posizione di 'at'.
+// Il lessema (value) è quello che il transpiler emette: i double
+// usano la forma più corta che rilegge lo stesso valore.
+// nullptr se il valore non ha un lessema (double non finiti).
+static std::shared_ptr<ASTNode> makeLiteral(const Value& v, const ASTNode& at) {
+    auto lit = std::make_shared<ASTNode>();
+    lit->setKind(NodeKind::Literal);
+    lit->line = at.line;
+    lit->column = at.column;
+
+    switch (v.tag) {
+        case Value::Tag::Int:
+            lit->tokenType = TokenType::NUMBER_INT;
+            lit->value = std::to_string(as<int>(v));
+            break;
+
+        case Value::Tag::Double: {
+            double d = as<double>(v);
+            if (!std::isfinite(d)) return nullptr;
+            char buf[32];
+            std::snprintf(buf, sizeof(buf), "%.15g", d);
+            if (std::strtod(buf, nullptr) != d)
+                std::snprintf(buf, sizeof(buf), "%.17g", d);
+            std::string text = buf;
+            if (text.find_first_of(".e") == std::string::npos) text += ".0";
+            lit->tokenType = TokenType::NUMBER_DBL;
+            lit->value = text;
+            break;
+        }
+
+        case Value::Tag::String:
+            lit->tokenType = TokenType::STRING;
+            lit->value = as<std::string>(v);
+            break;
+
+        default:
+            return nullptr;
+    }
+
+    lit->literal = v;
+    return lit;
+}
+
+// Copia di un Literal (costante propagata) nella posizione di 'at'
+static std::shared_ptr<ASTNode> copyLiteral(const ASTNode& lit, const ASTNode& at) {
+    auto copy = std::make_shared<ASTNode>(lit);
+    copy->line = at.line;
+    copy->column = at.column;
+    return copy;
+}
+
+// Truthiness di un literal (come Interpreter::isTruthy)
+static bool literalTruthy(const Value& v) {
+    switch (v.tag) {
+        case Value::Tag::Int:    return as<int>(v) != 0;
+        case Value::Tag::Double: return as<double>(v) != 0.0;
+        case Value::Tag::String: return !as<std::string>(v).empty();
+        default:                 return false;
+    }
+}
+
+static bool isNumber(const Value& v) {
+    return v.tag == Value::Tag::Int || v.tag == Value::Tag::Double;
+}
+
+static double numberOf(const Value& v) {
+    return v.tag == Value::Tag::Int ? static_cast<double>(as<int>(v)) : as<double>(v);
+}
+
+// Body di un solo ExprStmt con valore costante → il Literal
+static std::shared_ptr<ASTNode> unwrapBody(const std::shared_ptr<ASTNode>& node) {
+    if (node && node->kind == NodeKind::Body && node->children.size() == 1) {
+        auto& st = node->children[0];
+        if (st && st->kind == NodeKind::ExprStmt && st->children.size() == 1 &&
+            isLiteral(st->children[0]))
+            return st->children[0];
+    }
+    return node;
+}
+
+
+// ============================================================
+// Entry point
+// ============================================================
+void Optimizer::optimize(const std::shared_ptr<ASTNode>& program) {
+    if (!program) return;
+    declarations.clear();
+    assigned.clear();
+    constants.clear();
+
+    collectNames(program);
+
+    if (program->kind == NodeKind::Program) {
+        for (auto& ch : program->children) {
+            if (ch && ch->kind == NodeKind::Body) foldProgramBody(ch);
+            else ch = fold(ch);
+        }
+        return;
+    }
+    foldChildren(program);
+}
+
+// Come Resolver::collectBound, ma conta le dichiarazioni
+void Optimizer::collectNames(const std::shared_ptr<ASTNode>& node) {
+    if (!node) return;
+
+    switch (node->kind) {
+        case NodeKind::VarDecl:
+        case NodeKind::ArrayDecl:
+        case NodeKind::ForIn:
+        case NodeKind::Param:
+        case NodeKind::FunctionDef:
+            declarations[node->value]++;
+            break;
+
+        case NodeKind::Assign:
+            if (!node->children.empty() && node->children[0] &&
+                node->children[0]->kind == NodeKind::Identifier)
+                assigned.insert(node->children[0]->value);
+            break;
+
+        case NodeKind::Filter:
+            declarations["x"]++;
+            break;
+
+        default:
+            break;
+    }
+
+    for (auto& ch : node->children) collectNames(ch);
+}
+
+void Optimizer::foldProgramBody(const std::shared_ptr<ASTNode>& body) {
+    for (auto& st : body->children) {
+        st = fold(st);
+        if (!st || st->kind != NodeKind::VarDecl) continue;
+
+        bool isFixed = st->extra.count("fixed") && st->extra.at("fixed") == "true";
+        if (isFixed && st->children.size() == 1 && isLiteral(st->children[0]) &&
+            declarations[st->value] == 1 && !assigned.count(st->value))
+            constants[st->value] = st->children[0];
+    }
+}
+
+
+// ============================================================
+// Visita
+// ============================================================
+void Optimizer::foldChildren(const std::shared_ptr<ASTNode>& node) {
+    for (auto& ch : node->children) ch = fold(ch);
+}
+
+std::shared_ptr<ASTNode> Optimizer::fold(const std::shared_ptr<ASTNode>& node) {
+    if (!node) return node;
+
+    switch (node->kind) {
+        case NodeKind::Identifier: {
+            auto it = constants.find(node->value);
+            if (it != constants.end()) return copyLiteral(*it->second, *node);
+            return node;
+        }
+
+        case NodeKind::BinaryOp:
+        case NodeKind::LogicalOp:
+            foldChildren(node);
+            return foldBinary(node);
+
+        case NodeKind::UnaryOp:
+            foldChildren(node);
+            return foldUnary(node);
+
+        case NodeKind::IfExpr:
+            foldChildren(node);
+            return foldIf(node);
+
+        case NodeKind::CondChain:
+            foldChildren(node);
+            return foldCondChain(node);
+
+        case NodeKind::Call:
+            // array_push/array_pop leggono la variabile nominata dal primo argomento
+            if ((node->builtin == static_cast<int>(BuiltinId::ArrayPush) ||
+                 node->builtin == static_cast<int>(BuiltinId::ArrayPop)) &&
+                !node->children.empty() && node->children[0] &&
+                node->children[0]->kind == NodeKind::Identifier) {
+                for (size_t i = 1; i < node->children.size(); ++i)
+                    node->children[i] = fold(node->children[i]);
+                return node;
+            }
+            foldChildren(node);
+            return node;
+
+        case NodeKind::Assign:
+            // Il bersaglio non è una lettura
+            for (size_t i = 1; i < node->children.size(); ++i)
+                node->children[i] = fold(node->children[i]);
+            return node;
+
+        default:
+            foldChildren(node);
+            return node;
+    }
+}
+
+
+// ============================================================
+// Operatori
+// ============================================================
+std::shared_ptr<ASTNode> Optimizer::foldBinary(const std::shared_ptr<ASTNode>& node) {
+    if (node->children.size() != 2 ||
+        !isLiteral(node->children[0]) || !isLiteral(node->children[1]))
+        return node;
+
+    const Value& left = node->children[0]->literal;
+    const Value& right = node->children[1]->literal;
+    Operator op = node->op;
+
+    // ========== INT op INT ==========
+    if (left.tag == Value::Tag::Int && right.tag == Value::Tag::Int) {
+        int L = as<int>(left);
+        int R = as<int>(right);
+        int result;
+
+        switch (op) {
+            case Operator::Add:
+                if (__builtin_add_overflow(L, R, &result)) return node;
+                return makeLiteral(result, *node);
+            case Operator::Sub:
+                if (__builtin_sub_overflow(L, R, &result)) return node;
+                return makeLiteral(result, *node);
+            case Operator::Mul:
+                if (__builtin_mul_overflow(L, R, &result)) return node;
+                return makeLiteral(result, *node);
+            case Operator::Div:
+                if (R == 0 || (L == INT_MIN && R == -1)) return node;
+                return makeLiteral(L / R, *node);
+            case Operator::Mod:
+                if (R == 0 || (L == INT_MIN && R == -1)) return node;
+                return makeLiteral(L % R, *node);
+            case Operator::Pow: {
+                auto lit = makeLiteral(std::pow(static_cast<double>(L), static_cast<double>(R)), *node);
+                return lit ? lit : node;
+            }
+
+            case Operator::Lt: return makeLiteral((L <  R) ? 1 : 0, *node);
+            case Operator::Le: return makeLiteral((L <= R) ? 1 : 0, *node);
+            case Operator::Gt: return makeLiteral((L >  R) ? 1 : 0, *node);
+            case Operator::Ge: return makeLiteral((L >= R) ? 1 : 0, *node);
+            case Operator::Eq: return makeLiteral((L == R) ? 1 : 0, *node);
+            case Operator::Ne: return makeLiteral((L != R) ? 1 : 0, *node);
+
+            default: break;
+        }
+    }
+
+    // ========== DOUBLE op DOUBLE / INT op DOUBLE ==========
+    else if (isNumber(left) && isNumber(right)) {
+        double L = numberOf(left);
+        double R = numberOf(right);
+        std::shared_ptr<ASTNode> lit;
+
+        switch (op) {
+            case Operator::Add: lit = makeLiteral(L + R, *node); break;
+            case Operator::Sub: lit = makeLiteral(L - R, *node); break;
+            case Operator::Mul: lit = makeLiteral(L * R, *node); break;
+            case Operator::Div:
+                if (R == 0.0) return node;
+                lit = makeLiteral(L / R, *node);
+                break;
+            case Operator::Pow: lit = makeLiteral(std::pow(L, R), *node); break;
+
+            case Operator::Lt: return makeLiteral((L <  R) ? 1 : 0, *node);
+            case Operator::Le: return makeLiteral((L <= R) ? 1 : 0, *node);
+            case Operator::Gt: return makeLiteral((L >  R) ? 1 : 0, *node);
+            case Operator::Ge: return makeLiteral((L >= R) ? 1 : 0, *node);
+
+            // Mod dà errore; Eq/Ne confrontano la forma testuale
+            default: break;
+        }
+        if (lit) return lit;
+        return node;
+    }
+
+    switch (op) {
+        case Operator::Eq:
+        case Operator::Ne:
+            if (left.tag == Value::Tag::String && right.tag == Value::Tag::String) {
+                bool same = as<std::string>(left) == as<std::string>(right);
+                return makeLiteral((same == (op == Operator::Eq)) ? 1 : 0, *node);
+            }
+            return node;
+
+        case Operator::And:
+            return makeLiteral((literalTruthy(left) && literalTruthy(right)) ? 1 : 0, *node);
+        case Operator::Or:
+            return makeLiteral((literalTruthy(left) || literalTruthy(right)) ? 1 : 0, *node);
+
+        case Operator::Concat:
+            if (left.tag == Value::Tag::String && right.tag == Value::Tag::String)
+                return makeLiteral(as<std::string>(left) + as<std::string>(right), *node);
+            return node;
+
+        default:
+            return node;
+    }
+}
+
+std::shared_ptr<ASTNode> Optimizer::foldUnary(const std::shared_ptr<ASTNode>& node) {
+    if (node->children.size() != 1 || !isLiteral(node->children[0]))
+        return node;
+
+    const Value& v = node->children[0]->literal;
+
+    switch (node->op) {
+        case Operator::Neg:
+            if (v.tag == Value::Tag::Int && as<int>(v) != INT_MIN)
+                return makeLiteral(-as<int>(v), *node);
+            if (v.tag == Value::Tag::Double)
+                return makeLiteral(-as<double>(v), *node);
+            return node;
+
+        case Operator::Not:
+            return makeLiteral(literalTruthy(v) ? 0 : 1, *node);
+
+        default:
+            return node;
+    }
+}
+
+
+// ============================================================
+// Rami morti
+// ============================================================
+
+// IfExpr: [cond, then, (cond, body)*, else?]
+std::shared_ptr<ASTNode> Optimizer::foldIf(const std::shared_ptr<ASTNode>& node) {
+    if (node->children.size() < 2) return node;
+
+    int elifCount = 0;
+    bool hasElse = false;
+    if (node->extra.count("elifCount")) elifCount = std::stoi(node->extra.at("elifCount"));
+    if (node->extra.count("hasElse")) hasElse = node->extra.at("hasElse") == "true";
+
+    size_t pairs = 1 + static_cast<size_t>(elifCount);
+    if (2 * pairs + (hasElse ? 1 : 0) != node->children.size()) return node;
+
+    std::vector<std::shared_ptr<ASTNode>> kept;     // coppie (cond, body) residue
+    std::shared_ptr<ASTNode> elseBranch = hasElse ? node->children.back() : nullptr;
+
+    for (size_t i = 0; i < pairs; ++i) {
+        auto& cond = node->children[2 * i];
+        auto& body = node->children[2 * i + 1];
+        if (!isLiteral(cond)) {
+            kept.push_back(cond);
+            kept.push_back(body);
+            continue;
+        }
+        if (literalTruthy(cond->literal)) {
+            elseBranch = body;      // i rami successivi non sono mai raggiunti
+            break;
+        }
+        // condizione sempre falsa: ramo eliminato
+    }
+
+    if (kept.size() == 2 * pairs && elseBranch == (hasElse ? node->children.back() : nullptr))
+        return node;
+
+    bool multiline = node->extra.count("multiline") && node->extra.at("multiline") == "true";
+
+    if (kept.empty()) {
+        if (elseBranch) return multiline ? elseBranch : unwrapBody(elseBranch);
+        if (multiline) {
+            auto empty = std::make_shared<ASTNode>();
+            empty->setKind(NodeKind::Body);
+            empty->line = node->line;
+            empty->column = node->column;
+            return empty;
+        }
+        return makeLiteral(0, *node);
+    }
+
+    node->children = std::move(kept);
+    node->extra["elifCount"] = std::to_string(node->children.size() / 2 - 1);
+    node->extra["hasElse"] = elseBranch ? "true" : "false";
+    if (elseBranch) node->children.push_back(elseBranch);
+    return node;
+}
+
+// CondChain: SimpleCond(cond, risultato)..., fallback se hasFallback
+std::shared_ptr<ASTNode> Optimizer::foldCondChain(const std::shared_ptr<ASTNode>& node) {
+    if (node->condIncomplete) return node;
+
+    bool hasFallback = node->extra.count("hasFallback") && node->extra.at("hasFallback") == "1";
+    size_t limit = hasFallback ? node->children.size() - 1 : node->children.size();
+    if (hasFallback && node->children.empty()) return node;
+
+    std::vector<std::shared_ptr<ASTNode>> kept;
+    std::shared_ptr<ASTNode> fallback = hasFallback ? node->children.back() : nullptr;
+    bool changed = false;
+
+    for (size_t i = 0; i < limit; ++i) {
+        auto& sc = node->children[i];
+        if (!sc || sc->kind != NodeKind::SimpleCond || sc->children.size() < 2 ||
+            !isLiteral(sc->children[0])) {
+            kept.push_back(sc);
+            continue;
+        }
+        changed = true;
+        if (literalTruthy(sc->children[0]->literal)) {
+            fallback = sc->children[1];
+            break;
+        }
+    }
+
+    if (!changed) return node;
+
+    // Senza fallback la catena deve restare (il suo valore è un caso a parte)
+    if (!fallback && kept.empty()) return node;
+    if (kept.empty()) return fallback;
+
+    node->children = std::move(kept);
+    node->extra["hasFallback"] = std::string(fallback ? "1" : "0");
+    if (fallback) node->children.push_back(fallback);
+    return node;
+}
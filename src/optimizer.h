@@ -0,0 +1,56 @@
+#ifndef MAMMUTH_OPTIMIZER_H
+#define MAMMUTH_OPTIMIZER_H
+
+#include <memory>
+#include <set>
+#include <string>
+#include <unordered_map>
+
+#include "ast.h"
+
+// ============================================================
+// Optimizer: passata AST → AST tra il parser e l'esecuzione,
+// condivisa da Interpreter, VM e CPPTranspiler.
+//
+// - Constant folding: aritmetica, confronti, logici, unari e
+//   concatenazione '$' tra stringhe su operandi Literal. Un
+//   operatore si piega solo se a runtime non darebbe errore
+//   (divisione per zero, overflow int, tipi non supportati):
+//   in quei casi il nodo resta e l'errore resta a runtime.
+// - Rami morti: IfExpr e CondChain perdono i rami con condizione
+//   costante falsa; il primo ramo con condizione costante vera
+//   diventa l'else/fallback. Senza rami residui il nodo è
+//   sostituito dal ramo scelto.
+// - Propagazione delle costanti 'fixed': una VarDecl fixed del
+//   programma (non annidata) con valore Literal, unica
+//   dichiarazione del nome e mai assegnata, sostituisce le
+//   letture del nome negli statement successivi.
+// ============================================================
+class Optimizer {
+public:
+    void optimize(const std::shared_ptr<ASTNode>& program);
+
+private:
+    // Nomi dichiarati/assegnati: solo quelli con una sola dichiarazione
+    // e nessun assegnamento possono diventare costanti
+    std::unordered_map<std::string, int> declarations;
+    std::set<std::string> assigned;
+    void collectNames(const std::shared_ptr<ASTNode>& node);
+
+    // Costanti propagabili visibili nel punto corrente
+    std::unordered_map<std::string, std::shared_ptr<ASTNode>> constants;
+
+    // Restituisce il nodo ottimizzato (lo stesso o un sostituto)
+    std::shared_ptr<ASTNode> fold(const std::shared_ptr<ASTNode>& node);
+    void foldChildren(const std::shared_ptr<ASTNode>& node);
+
+    std::shared_ptr<ASTNode> foldBinary(const std::shared_ptr<ASTNode>& node);
+    std::shared_ptr<ASTNode> foldUnary(const std::shared_ptr<ASTNode>& node);
+    std::shared_ptr<ASTNode> foldIf(const std::shared_ptr<ASTNode>& node);
+    std::shared_ptr<ASTNode> foldCondChain(const std::shared_ptr<ASTNode>& node);
+
+    // Statement del programma: registra le costanti fixed dopo la loro VarDecl
+    void foldProgramBody(const std::shared_ptr<ASTNode>& body);
+};
+
+#endif // MAMMUTH_OPTIMIZER_H
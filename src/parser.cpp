@@ -1,6 +1,10 @@
 #include "parser.h"
+#include "builtins.h"
 #include "debug.h"
 
+#include <algorithm>
+#include <stdexcept>
+
 Parser::Parser(const std::vector<Token>& tokens)
     : tokens(tokens)
 {
@@ -13,7 +17,7 @@ Parser::Parser(const std::vector<Token>& tokens)
    ============================================================ */
 
 const Token& Parser::peek() const {
-    static Token eof{TokenType::END_OF_FILE, "EOF", 0, 0};
+    static Token eof{TokenType::END_OF_FILE, NO_SYMBOL, "EOF", 0, 0};
     if (pos >= tokens.size())
         return eof;
     return tokens[pos];
@@ -82,10 +86,30 @@ void Parser::skipContinuationNewlines() {
         advance();
 }
 
+// Decodifica il lessema di un literal nel Value corrispondente.
+// I literal senza tipo token (creati dal parser) valgono int se sono solo cifre.
+static Value decodeLiteral(TokenType type, const std::string& v) {
+    try {
+        if (type == TokenType::NUMBER_INT) return std::stoi(v);
+        if (type == TokenType::NUMBER_DBL) return std::stod(v);
+        if (type == TokenType::STRING) return v;
+
+        bool isNumber = !v.empty() &&
+                        std::all_of(v.begin(), v.end(),
+                                    [](char c){ return (c >= '0' && c <= '9'); });
+        if (isNumber) return std::stoi(v);
+    } catch (const std::out_of_range&) {
+        std::cerr << "Errore: numero fuori range: " << v << "\n";
+        return 0;
+    }
+    return v;
+}
+
 std::shared_ptr<ASTNode> Parser::makeLiteral(const std::string& v) {
     auto n = std::make_shared<ASTNode>();
-    n->type = "Literal";
+    n->setKind(NodeKind::Literal);
     n->value = v;
+    n->literal = decodeLiteral(n->tokenType, v);
     return n;
 }
 
@@ -96,10 +120,10 @@ std::shared_ptr<ASTNode> Parser::makeLiteral(const std::string& v) {
 
 std::shared_ptr<ASTNode> Parser::parseProgram() {
     auto prog = std::make_shared<ASTNode>();
-    prog->type = "Program";
+    prog->setKind(NodeKind::Program);
 
     auto body = std::make_shared<ASTNode>();
-    body->type = "Body";
+    body->setKind(NodeKind::Body);
 
     while (!check(TokenType::END_OF_FILE)) {
 
@@ -150,7 +174,7 @@ std::shared_ptr<ASTNode> Parser::parseStatement() {
             pos = saved; // ripristina
             auto expr = parseExpression();
             auto stmt = std::make_shared<ASTNode>();
-            stmt->type = "ExprStmt";
+            stmt->setKind(NodeKind::ExprStmt);
             stmt->children.push_back(expr);
             return stmt;
         }
@@ -161,7 +185,7 @@ std::shared_ptr<ASTNode> Parser::parseStatement() {
        ====================================================== */
     if (match(TokenType::KW_ECHO)) {
         auto node = std::make_shared<ASTNode>();
-        node->type = "Echo";
+        node->setKind(NodeKind::Echo);
 
         // echo senza parametri → stampa newline
         if (check(TokenType::NEWLINE) || check(TokenType::END_OF_FILE)) {
@@ -171,7 +195,7 @@ std::shared_ptr<ASTNode> Parser::parseStatement() {
 
         auto e = parseExpression();
 
-        if (e && e->type == "CondChain" && e->condIncomplete) {
+        if (e && e->kind == NodeKind::CondChain && e->condIncomplete) {
             std::cerr << "Errore: CondChain senza fallback non valida in echo\n";
         }
 
@@ -185,7 +209,7 @@ std::shared_ptr<ASTNode> Parser::parseStatement() {
        ====================================================== */
     if (match(TokenType::KW_WHILE)) {
         auto whileNode = std::make_shared<ASTNode>();
-        whileNode->type = "While";
+        whileNode->setKind(NodeKind::While);
         
         if (!match(TokenType::LPAREN)) {
             std::cerr << "Errore while: atteso (\n";
@@ -207,13 +231,14 @@ std::shared_ptr<ASTNode> Parser::parseStatement() {
                 return nullptr;
             }
             whileNode->extra["returnVar"] = peek().lexeme;
+            whileNode->returnVar = peek().sym;
             advance();
         }
         
         // Body: blocco :: ... end o statement inline
         if (match(TokenType::DOUBLE_COLON)) {
             auto body = std::make_shared<ASTNode>();
-            body->type = "Body";
+            body->setKind(NodeKind::Body);
             
             skipContinuationNewlines();
             
@@ -246,15 +271,16 @@ std::shared_ptr<ASTNode> Parser::parseStatement() {
        ====================================================== */
     if (match(TokenType::KW_FOR)) {
         auto forNode = std::make_shared<ASTNode>();
-        forNode->type = "ForIn";
+        forNode->setKind(NodeKind::ForIn);
         
         if (!check(TokenType::IDENT)) {
             std::cerr << "Errore for: atteso nome variabile\n";
             return nullptr;
         }
         
-        std::string iterVar = peek().lexeme;
+        std::string iterVar(peek().lexeme);
         forNode->value = iterVar;
+        forNode->sym = peek().sym;
         advance();
         
         if (!match(TokenType::KW_IN)) {
@@ -272,13 +298,14 @@ std::shared_ptr<ASTNode> Parser::parseStatement() {
                 return nullptr;
             }
             forNode->extra["returnVar"] = peek().lexeme;
+            forNode->returnVar = peek().sym;
             advance();
         }
         
         // Body: blocco :: ... end o statement inline
         if (match(TokenType::DOUBLE_COLON)) {
             auto body = std::make_shared<ASTNode>();
-            body->type = "Body";
+            body->setKind(NodeKind::Body);
             
             skipContinuationNewlines();
             
@@ -387,7 +414,8 @@ std::shared_ptr<ASTNode> Parser::parseStatement() {
             return nullptr;
         }
 
-        std::string name = tokens[pos-1].lexeme;
+        std::string name(tokens[pos-1].lexeme);
+        Symbol sym = tokens[pos-1].sym;
 
         // Deve esserci =
         if (!match(TokenType::ASSIGN)) {
@@ -399,8 +427,9 @@ std::shared_ptr<ASTNode> Parser::parseStatement() {
         auto expr = parseExpression();
 
         auto var = std::make_shared<ASTNode>();
-        var->type = "VarDecl";
+        var->setKind(NodeKind::VarDecl);
         var->value = name;
+        var->sym = sym;
         var->extra["type"] = "function";
         var->extra["fixed"] = "true";  // SEMPRE immutabile!
         var->extra["isFunctionVar"] = "true";
@@ -423,28 +452,30 @@ std::shared_ptr<ASTNode> Parser::parseStatement() {
         match(TokenType::KW_ZERO))
     {
         TokenType typeToken = tokens[pos-1].type;
-        std::string typeLex = tokens[pos-1].lexeme;
+        std::string typeLex(tokens[pos-1].lexeme);
 
         if (!match(TokenType::IDENT)) {
             std::cerr << "Errore: atteso nome variabile\n";
             return nullptr;
         }
 
-        std::string name = tokens[pos-1].lexeme;
+        std::string name(tokens[pos-1].lexeme);
+        Symbol sym = tokens[pos-1].sym;
 
         /* ===== ARRAY ===== */
         if (match(TokenType::LBRACKET)) {
 
             // array statico: int arr[10]
             if (match(TokenType::NUMBER_INT)) {
-                int sizeVal = std::stoi(tokens[pos-1].lexeme);
+                int sizeVal = std::stoi(std::string(tokens[pos-1].lexeme));
 
                 if (!match(TokenType::RBRACKET))
                     std::cerr << "Errore: atteso ']'\n";
 
                 auto node = std::make_shared<ASTNode>();
-                node->type = "ArrayDecl";
+                node->setKind(NodeKind::ArrayDecl);
                 node->value = name;
+                node->sym = sym;
                 node->extra["size"] = std::to_string(sizeVal);
                 node->extra["dynamic"] = isDynamic ? "true" : "false";
                 node->extra["fixed"] = isFixed ? "true" : "false";
@@ -457,8 +488,8 @@ std::shared_ptr<ASTNode> Parser::parseStatement() {
                     default: node->extra["type"]="int";
                 }
 
-                arrayTypes[name] = node->extra["type"];
-                arrayMutable[name] = isDynamic;
+                arrayTypes[sym] = node->extra["type"];
+                arrayMutable[sym] = isDynamic;
                 return node;
             }
 
@@ -466,8 +497,9 @@ std::shared_ptr<ASTNode> Parser::parseStatement() {
             if (match(TokenType::RBRACKET)) {
 
                 auto node = std::make_shared<ASTNode>();
-                node->type = "ArrayDecl";
+                node->setKind(NodeKind::ArrayDecl);
                 node->value = name;
+                node->sym = sym;
                 node->extra["dynamic"] = isDynamic ? "true" : "false";
                 node->extra["fixed"] = isFixed ? "true" : "false";
 
@@ -503,7 +535,7 @@ std::shared_ptr<ASTNode> Parser::parseStatement() {
                          tt != TokenType::MINUS))
                     {
                         auto empty = std::make_shared<ASTNode>();
-                        empty->type = "ArrayInit";
+                        empty->setKind(NodeKind::ArrayInit);
                         node->children.push_back(empty);
                     }
                     else {
@@ -512,8 +544,8 @@ std::shared_ptr<ASTNode> Parser::parseStatement() {
                     }
                 }
 
-                arrayTypes[name] = node->extra["type"];
-                arrayMutable[name] = isDynamic;
+                arrayTypes[sym] = node->extra["type"];
+                arrayMutable[sym] = isDynamic;
                 return node;
             }
 
@@ -523,8 +555,9 @@ std::shared_ptr<ASTNode> Parser::parseStatement() {
 
         /* ===== VAR semplice ===== */
         auto var = std::make_shared<ASTNode>();
-        var->type      = "VarDecl";
+        var->setKind(NodeKind::VarDecl);
         var->value     = name;
+        var->sym       = sym;
         var->extra["dynamic"] = isDynamic ? "true" : "false";
         var->extra["fixed"] = isFixed ? "true" : "false";
 
@@ -550,7 +583,7 @@ std::shared_ptr<ASTNode> Parser::parseStatement() {
     auto expr = parseExpression();
 
     auto stmt = std::make_shared<ASTNode>();
-    stmt->type = "ExprStmt";
+    stmt->setKind(NodeKind::ExprStmt);
     stmt->children.push_back(expr);
     return stmt;
 }
@@ -575,7 +608,7 @@ std::shared_ptr<ASTNode> Parser::parseAssignment() {
     }
 
     // Verifica LHS valido
-    if (lhs->type != "Identifier" && lhs->type != "ArrayAccess") {
+    if (lhs->kind != NodeKind::Identifier && lhs->kind != NodeKind::ArrayAccess) {
         pos = saved;
         return nullptr;
     }
@@ -592,10 +625,11 @@ std::shared_ptr<ASTNode> Parser::parseAssignment() {
     if (!rhs) rhs = makeLiteral("0");
 
     auto node = std::make_shared<ASTNode>();
-    node->type = "Assign";
+    node->setKind(NodeKind::Assign);
 
-    if (lhs->type == "Identifier") {
+    if (lhs->kind == NodeKind::Identifier) {
         node->value = lhs->value;
+        node->sym = lhs->sym;
     }
 
     node->children.push_back(lhs);
@@ -617,7 +651,7 @@ std::shared_ptr<ASTNode> Parser::parseExpression(int) {
     expr = parseElvis(expr);
     expr = parseFilter(expr);
     // ★ Se la CondChain è incompleta, vieta l’uso dentro espressioni
-    if (expr && expr->type == "CondChain" && expr->condIncomplete) {
+    if (expr && expr->kind == NodeKind::CondChain && expr->condIncomplete) {
         std::cerr << "Errore: CondChain senza fallback in contesto che richiede un valore\n";
     }
 
@@ -643,7 +677,7 @@ std::shared_ptr<ASTNode> Parser::parseCondChain() {
         return first;
 
     auto chain = std::make_shared<ASTNode>();
-    chain->type = "CondChain";
+    chain->setKind(NodeKind::CondChain);
     chain->children.push_back(first);
     
     while (match(TokenType::DOUBLE_QUESTION)) {
@@ -689,7 +723,7 @@ std::shared_ptr<ASTNode> Parser::parseSimpleCond() {
     if (!expr) expr = makeLiteral("0");
 
     auto node = std::make_shared<ASTNode>();
-    node->type = "SimpleCond";
+    node->setKind(NodeKind::SimpleCond);
     node->children.push_back(cond);
     node->children.push_back(expr);
     return node;
@@ -723,11 +757,13 @@ std::shared_ptr<ASTNode> Parser::parseBaseExpression(int precedence) {
             
             // Se left è Identifier, usa Call normale
             // Altrimenti usa CallExpr
-            if (left->type == "Identifier") {
-                call->type = "Call";
+            if (left->kind == NodeKind::Identifier) {
+                call->setKind(NodeKind::Call);
                 call->value = left->value;
+                call->sym = left->sym;
+                call->builtin = findBuiltin(call->value);
             } else {
-                call->type = "CallExpr";
+                call->setKind(NodeKind::CallExpr);
                 call->children.push_back(left);
             }
             
@@ -756,18 +792,20 @@ std::shared_ptr<ASTNode> Parser::parseBaseExpression(int precedence) {
             auto rangeNode = parseRange();
             
             auto acc = std::make_shared<ASTNode>();
-            acc->type = "ArrayAccess";
+            acc->setKind(NodeKind::ArrayAccess);
             
             if (rangeNode) {
                 // Slice: arr[start..end]
-                if (left->type == "Identifier") {
+                if (left->kind == NodeKind::Identifier) {
                     acc->value = left->value;
+                    acc->sym = left->sym;
                     
-                    auto& name = left->value;
-                    if (arrayTypes.count(name))
-                        acc->extra["elemType"] = arrayTypes[name];
-                    if (arrayMutable.count(name))
-                        acc->extra["dynamic"] = arrayMutable[name] ? "true" : "false";
+                    auto elemType = arrayTypes.find(left->sym);
+                    if (elemType != arrayTypes.end())
+                        acc->extra["elemType"] = elemType->second;
+                    auto mut = arrayMutable.find(left->sym);
+                    if (mut != arrayMutable.end())
+                        acc->extra["dynamic"] = mut->second ? "true" : "false";
                 } else {
                     acc->value = "";
                     acc->children.push_back(left);
@@ -783,14 +821,16 @@ std::shared_ptr<ASTNode> Parser::parseBaseExpression(int precedence) {
                     std::cerr << "Errore: atteso ]\n";
                 }
                 
-                if (left->type == "Identifier") {
+                if (left->kind == NodeKind::Identifier) {
                     acc->value = left->value;
+                    acc->sym = left->sym;
                     
-                    auto& name = left->value;
-                    if (arrayTypes.count(name))
-                        acc->extra["elemType"] = arrayTypes[name];
-                    if (arrayMutable.count(name))
-                        acc->extra["dynamic"] = arrayMutable[name] ? "true" : "false";
+                    auto elemType = arrayTypes.find(left->sym);
+                    if (elemType != arrayTypes.end())
+                        acc->extra["elemType"] = elemType->second;
+                    auto mut = arrayMutable.find(left->sym);
+                    if (mut != arrayMutable.end())
+                        acc->extra["dynamic"] = mut->second ? "true" : "false";
                 } else {
                     acc->value = "";
                     acc->children.push_back(left);
@@ -812,7 +852,7 @@ std::shared_ptr<ASTNode> Parser::parseBaseExpression(int precedence) {
         if (prec < 0 || prec < precedence)
             break;
 
-        std::string op = peek().lexeme;
+        std::string op(peek().lexeme);
         advance();
 
         skipContinuationNewlines();
@@ -829,7 +869,7 @@ std::shared_ptr<ASTNode> Parser::parseBaseExpression(int precedence) {
             if (match(TokenType::COLON)) {
                 // [:end] o [:]
                 auto slice = std::make_shared<ASTNode>();
-                slice->type = "Slice";
+                slice->setKind(NodeKind::Slice);
                 slice->extra["start"] = "";  // Empty = from beginning
                 
                 if (!check(TokenType::RBRACKET)) {
@@ -846,7 +886,7 @@ std::shared_ptr<ASTNode> Parser::parseBaseExpression(int precedence) {
                 if (match(TokenType::DOUBLE_COLON)) {
                     // [start..]
                     auto slice = std::make_shared<ASTNode>();
-                    slice->type = "Slice";
+                    slice->setKind(NodeKind::Slice);
                     slice->children.push_back(first);
                     slice->extra["end"] = "";  // To end
                     indexOrSlice = slice;
@@ -854,7 +894,7 @@ std::shared_ptr<ASTNode> Parser::parseBaseExpression(int precedence) {
                 } else if (match(TokenType::COLON)) {
                     // [start:end]
                     auto slice = std::make_shared<ASTNode>();
-                    slice->type = "Slice";
+                    slice->setKind(NodeKind::Slice);
                     slice->children.push_back(first);
                     
                     if (!check(TokenType::RBRACKET)) {
@@ -878,13 +918,14 @@ std::shared_ptr<ASTNode> Parser::parseBaseExpression(int precedence) {
             
             // Crea: left $ left[...]
             auto access = std::make_shared<ASTNode>();
-            access->type = "ArrayAccess";
+            access->setKind(NodeKind::ArrayAccess);
             access->children.push_back(left);  // array
             access->children.push_back(indexOrSlice);  // index/slice
             
             auto concat = std::make_shared<ASTNode>();
-            concat->type = "BinaryOp";
+            concat->setKind(NodeKind::BinaryOp);
             concat->value = "$";
+            concat->op = Operator::Concat;
             concat->children.push_back(left);
             concat->children.push_back(access);
             
@@ -898,13 +939,13 @@ std::shared_ptr<ASTNode> Parser::parseBaseExpression(int precedence) {
         if (!right) right = makeLiteral("0");
 
         auto node = std::make_shared<ASTNode>();
-        node->type = (op == "and" || op == "or") ? "LogicalOp" : "BinaryOp";
+        node->setKind((op == "and" || op == "or") ? NodeKind::LogicalOp : NodeKind::BinaryOp);
 
         if (op == ",") {
             auto list = std::make_shared<ASTNode>();
-            list->type = "CommaList";
+            list->setKind(NodeKind::CommaList);
 
-            if (left->type == "CommaList")
+            if (left->kind == NodeKind::CommaList)
                 list->children = left->children;
             else
                 list->children.push_back(left);
@@ -915,6 +956,7 @@ std::shared_ptr<ASTNode> Parser::parseBaseExpression(int precedence) {
         }
 
         node->value = op;
+        node->op = binaryOperator(op);
         node->children.push_back(left);
         node->children.push_back(right);
         left = node;
@@ -959,7 +1001,7 @@ std::shared_ptr<ASTNode> Parser::parsePrimary() {
                     return nullptr;
                 }
                 
-                std::string pname = peek().lexeme;
+                std::string pname(peek().lexeme);
                 advance();
                 
                 if (!match(TokenType::COLON)) {
@@ -1057,14 +1099,15 @@ std::shared_ptr<ASTNode> Parser::parsePrimary() {
         advance();
         
         auto lambda = std::make_shared<ASTNode>();
-        lambda->type = "Lambda";
+        lambda->setKind(NodeKind::Lambda);
         lambda->value = "<anonymous>";
         lambda->extra["returnType"] = retType;
         
         for (auto& p : params) {
             auto pn = std::make_shared<ASTNode>();
-            pn->type = "Param";
+            pn->setKind(NodeKind::Param);
             pn->value = p.second;
+            pn->sym = internSymbol(p.second);
             pn->extra["paramType"] = p.first;
             lambda->children.push_back(pn);
         }
@@ -1073,7 +1116,7 @@ std::shared_ptr<ASTNode> Parser::parsePrimary() {
         if (match(TokenType::DOUBLE_COLON)) {
             // Blocco: def(...) -> tipo:: ... end
             auto body = std::make_shared<ASTNode>();
-            body->type = "Body";
+            body->setKind(NodeKind::Body);
             
             skipContinuationNewlines();
             
@@ -1095,10 +1138,10 @@ std::shared_ptr<ASTNode> Parser::parsePrimary() {
             // Espressione singola: def(...) -> tipo expr
             auto expr = parseExpression();
             auto body = std::make_shared<ASTNode>();
-            body->type = "Body";
+            body->setKind(NodeKind::Body);
             
             auto exprStmt = std::make_shared<ASTNode>();
-            exprStmt->type = "ExprStmt";
+            exprStmt->setKind(NodeKind::ExprStmt);
             exprStmt->children.push_back(expr);
             body->children.push_back(exprStmt);
             
@@ -1113,26 +1156,29 @@ std::shared_ptr<ASTNode> Parser::parsePrimary() {
         tok.type == TokenType::BNOT ||
         tok.type == TokenType::NOT)
     {
-        std::string op = tok.lexeme;
+        std::string op(tok.lexeme);
         advance();
         skipContinuationNewlines();
         auto expr = parsePrimary();
 
         auto u = std::make_shared<ASTNode>();
-        u->type = "UnaryOp";
+        u->setKind(NodeKind::UnaryOp);
         u->value = op;
+        u->op = unaryOperator(op);
         u->children.push_back(expr);
         return u;
     }
 
     // Identificatore
     if (tok.type == TokenType::IDENT) {
-        std::string name = tok.lexeme;
+        std::string name(tok.lexeme);
+        Symbol sym = tok.sym;
         advance();
 
         auto id = std::make_shared<ASTNode>();
-        id->type = "Identifier";
+        id->setKind(NodeKind::Identifier);
         id->value = name;
+        id->sym = sym;
 
         // NOTE: Call e array access gestiti in parseBaseExpression
         // come operatori postfix, così supportano chiamate multiple
@@ -1158,9 +1204,10 @@ std::shared_ptr<ASTNode> Parser::parsePrimary() {
         tok.type == TokenType::NUMBER_DBL ||
         tok.type == TokenType::STRING) {
         auto lit = std::make_shared<ASTNode>();
-        lit->type = "Literal";
+        lit->setKind(NodeKind::Literal);
         lit->value = tok.lexeme;
         lit->tokenType = tok.type;
+        lit->literal = decodeLiteral(tok.type, lit->value);
         advance();
         return lit;
     }
@@ -1182,7 +1229,7 @@ std::shared_ptr<ASTNode> Parser::parsePrimary() {
             advance(); // consuma (
             
             auto call = std::make_shared<ASTNode>();
-            call->type = "CallExpr";  // Nuovo tipo per distinguere da Call normale
+            call->setKind(NodeKind::CallExpr);  // Nuovo tipo per distinguere da Call normale
             call->children.push_back(expr);  // Espressione da chiamare
             
             skipContinuationNewlines();
@@ -1236,7 +1283,7 @@ std::shared_ptr<ASTNode> Parser::parseElvis(std::shared_ptr<ASTNode> left) {
         if (!right) right = makeLiteral("0");
 
         auto node = std::make_shared<ASTNode>();
-        node->type = "Elvis";
+        node->setKind(NodeKind::Elvis);
         node->children.push_back(left);
         node->children.push_back(right);
         left = node;
@@ -1258,7 +1305,7 @@ std::shared_ptr<ASTNode> Parser::parseFilter(std::shared_ptr<ASTNode> left) {
         if (!cond) cond = makeLiteral("0");
 
         auto node = std::make_shared<ASTNode>();
-        node->type = "Filter";
+        node->setKind(NodeKind::Filter);
         node->children.push_back(left);
         node->children.push_back(cond);
         left = node;
@@ -1272,7 +1319,7 @@ std::shared_ptr<ASTNode> Parser::parseFilter(std::shared_ptr<ASTNode> left) {
    ============================================================ */
 std::shared_ptr<ASTNode> Parser::parseArrayInitializer() {
     auto list = std::make_shared<ASTNode>();
-    list->type = "ArrayInit";
+    list->setKind(NodeKind::ArrayInit);
     list->children.push_back(parseExpression());  // ✅ FIX: parseExpression invece di parseBaseExpression
     while (match(TokenType::COMMA)) {
         skipContinuationNewlines();
@@ -1292,7 +1339,7 @@ std::shared_ptr<ASTNode> Parser::parseRange() {
     if (match(TokenType::RANGE)) {
 
         auto node = std::make_shared<ASTNode>();
-        node->type = "RangeExpr";
+        node->setKind(NodeKind::RangeExpr);
         node->extra["hasStart"] = "false";
 
         skipContinuationNewlines();
@@ -1319,7 +1366,7 @@ std::shared_ptr<ASTNode> Parser::parseRange() {
 
     if (match(TokenType::RANGE)) {
         auto node = std::make_shared<ASTNode>();
-        node->type = "RangeExpr";
+        node->setKind(NodeKind::RangeExpr);
         node->children.push_back(startExpr);
         node->extra["hasStart"] = "true";
 
@@ -1392,7 +1439,7 @@ std::shared_ptr<ASTNode> Parser::parseIfExpr() {
     }
     
     auto ifNode = std::make_shared<ASTNode>();
-    ifNode->type = "IfExpr";
+    ifNode->setKind(NodeKind::IfExpr);
     
     // Parse condition
     skipContinuationNewlines();
@@ -1417,7 +1464,7 @@ std::shared_ptr<ASTNode> Parser::parseIfExpr() {
     
     // Parse then body
     auto thenBody = std::make_shared<ASTNode>();
-    thenBody->type = "Body";
+    thenBody->setKind(NodeKind::Body);
     
     if (isMultiline) {
         // Multi-line: parse statements fino a elif/else/end
@@ -1441,7 +1488,7 @@ std::shared_ptr<ASTNode> Parser::parseIfExpr() {
             return nullptr;
         }
         auto exprStmt = std::make_shared<ASTNode>();
-        exprStmt->type = "ExprStmt";
+        exprStmt->setKind(NodeKind::ExprStmt);
         exprStmt->children.push_back(expr);
         thenBody->children.push_back(exprStmt);
     }
@@ -1476,7 +1523,7 @@ std::shared_ptr<ASTNode> Parser::parseIfExpr() {
         }
         
         auto elifBody = std::make_shared<ASTNode>();
-        elifBody->type = "Body";
+        elifBody->setKind(NodeKind::Body);
         
         if (elifMultiline) {
             while (!check(TokenType::KW_ELIF) && 
@@ -1498,7 +1545,7 @@ std::shared_ptr<ASTNode> Parser::parseIfExpr() {
                 return nullptr;
             }
             auto exprStmt = std::make_shared<ASTNode>();
-            exprStmt->type = "ExprStmt";
+            exprStmt->setKind(NodeKind::ExprStmt);
             exprStmt->children.push_back(expr);
             elifBody->children.push_back(exprStmt);
         }
@@ -1527,7 +1574,7 @@ std::shared_ptr<ASTNode> Parser::parseIfExpr() {
         }
         
         auto elseBody = std::make_shared<ASTNode>();
-        elseBody->type = "Body";
+        elseBody->setKind(NodeKind::Body);
         
         if (elseMultiline) {
             while (!check(TokenType::KW_END) && !check(TokenType::END_OF_FILE)) {
@@ -1546,7 +1593,7 @@ std::shared_ptr<ASTNode> Parser::parseIfExpr() {
                 return nullptr;
             }
             auto exprStmt = std::make_shared<ASTNode>();
-            exprStmt->type = "ExprStmt";
+            exprStmt->setKind(NodeKind::ExprStmt);
             exprStmt->children.push_back(expr);
             elseBody->children.push_back(exprStmt);
         }
@@ -1588,7 +1635,8 @@ std::shared_ptr<ASTNode> Parser::parseFunctionDef() {
         return nullptr;
     }
 
-    std::string fname = peek().lexeme;
+    std::string fname(peek().lexeme);
+    Symbol fsym = peek().sym;
     advance();
 
     if (!match(TokenType::LPAREN)) {
@@ -1605,7 +1653,7 @@ std::shared_ptr<ASTNode> Parser::parseFunctionDef() {
                 return nullptr;
             }
 
-            std::string pname = peek().lexeme;
+            std::string pname(peek().lexeme);
             advance();
 
             if (!match(TokenType::COLON)) {
@@ -1757,20 +1805,22 @@ std::shared_ptr<ASTNode> Parser::parseFunctionDef() {
     }
 
     auto func = std::make_shared<ASTNode>();
-    func->type = "FunctionDef";
+    func->setKind(NodeKind::FunctionDef);
     func->value = fname;
+    func->sym = fsym;
     func->extra["returnType"] = retType;
 
     for (auto& p : params) {
         auto pn = std::make_shared<ASTNode>();
-        pn->type = "Param";
+        pn->setKind(NodeKind::Param);
         pn->value = p.second;
+        pn->sym = internSymbol(p.second);
         pn->extra["paramType"] = p.first;
         func->children.push_back(pn);
     }
 
     auto body = std::make_shared<ASTNode>();
-    body->type = "Body";
+    body->setKind(NodeKind::Body);
 
     while (match(TokenType::NEWLINE));
 
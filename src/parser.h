@@ -25,10 +25,10 @@ public:
 private:
     const std::vector<Token>& tokens;
 
-    // Tipo elemento array (int, double, string, zero)
-    std::unordered_map<std::string, std::string> arrayTypes;
+    // Tipo elemento array (int, double, string, zero), per simbolo del nome
+    std::unordered_map<Symbol, std::string> arrayTypes;
     // Mutabilità degli array
-    std::unordered_map<std::string, bool> arrayMutable;
+    std::unordered_map<Symbol, bool> arrayMutable;
 
     size_t pos = 0;
 
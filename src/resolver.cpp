@@ -0,0 +1,607 @@
+#include "resolver.h"
+#include "builtins.h"
+#include "debug.h"
+
+// ============================================================
+// Entry point
+// ============================================================
+void Resolver::resolve(const std::shared_ptr<ASTNode>& program) {
+    if (!program) return;
+    frames.clear();
+    callSites = 0;
+    memoTables = 0;
+    bodies.clear();
+    bodyIndex.clear();
+    defsByName.clear();
+    boundNames.clear();
+    varNames.clear();
+
+    collectBound(program);
+    collectBodies(program);
+    computeCaptures();
+    resolveFrame(program, program, {}, false);
+    computePurity();
+}
+
+void Resolver::resolveFrame(const std::shared_ptr<ASTNode>& owner,
+                            const std::shared_ptr<ASTNode>& body,
+                            const std::vector<Symbol>& params,
+                            bool transparent)
+{
+    owner->frame = std::make_shared<FrameLayout>();
+    for (auto& p : params) owner->frame->add(p);
+    declare(body, *owner->frame);
+
+    // Variabili libere: vivono anch'esse negli slot del frame
+    auto it = bodyIndex.find(owner.get());
+    if (it != bodyIndex.end()) {
+        const BodyInfo& info = bodies[it->second];
+        for (auto& name : info.names) {
+            if (info.params.count(name)) continue;
+            owner->frame->captures.push_back(owner->frame->add(name));
+        }
+    }
+
+    DEBUG_INTERP_LOG("Resolver: frame " << owner->type << " con "
+                     << owner->frame->size() << " slot");
+
+    frames.push_back({owner->frame.get(), transparent});
+    visit(body);
+    frames.pop_back();
+}
+
+// ============================================================
+// Nomi legati (variabili, parametri, def)
+// ============================================================
+void Resolver::collectBound(const std::shared_ptr<ASTNode>& node) {
+    if (!node) return;
+
+    switch (node->kind) {
+        case NodeKind::VarDecl:
+        case NodeKind::ArrayDecl:
+        case NodeKind::ForIn:
+        case NodeKind::Param:
+            boundNames.insert(node->sym);
+            varNames.insert(node->sym);
+            break;
+
+        case NodeKind::FunctionDef:
+            boundNames.insert(node->sym);
+            break;
+
+        case NodeKind::Assign:
+            if (!node->children.empty() && node->children[0] &&
+                node->children[0]->kind == NodeKind::Identifier) {
+                boundNames.insert(node->children[0]->sym);
+                varNames.insert(node->children[0]->sym);
+            }
+            break;
+
+        case NodeKind::Filter:
+            boundNames.insert(filterItem);
+            varNames.insert(filterItem);
+            break;
+
+        default:
+            break;
+    }
+
+    for (auto& ch : node->children) collectBound(ch);
+}
+
+// ============================================================
+// Variabili libere (closure)
+// ============================================================
+void Resolver::collectBodies(const std::shared_ptr<ASTNode>& node) {
+    if (!node) return;
+
+    if (node->kind == NodeKind::FunctionDef || node->kind == NodeKind::Lambda) {
+        std::vector<Symbol> params;
+        for (auto& ch : node->children) {
+            if (!ch) continue;
+            if (ch->kind == NodeKind::Param) {
+                params.push_back(ch->sym);
+            } else if (node->kind == NodeKind::Lambda || ch->kind == NodeKind::Body) {
+                addBody(ch, params,
+                        node->kind == NodeKind::FunctionDef ? node->sym : NO_SYMBOL);
+                break;
+            }
+        }
+    }
+
+    for (auto& ch : node->children) collectBodies(ch);
+}
+
+void Resolver::addBody(const std::shared_ptr<ASTNode>& body,
+                       const std::vector<Symbol>& params,
+                       Symbol funcName)
+{
+    size_t idx = bodies.size();
+    bodies.emplace_back();
+    BodyInfo& info = bodies.back();
+    info.body = body;
+    info.isDef = funcName != NO_SYMBOL;
+    info.params.insert(params.begin(), params.end());
+    collectNames(body, info);
+
+    bodyIndex[body.get()] = idx;
+    if (funcName != NO_SYMBOL) defsByName[funcName].push_back(idx);
+}
+
+void Resolver::collectNames(const std::shared_ptr<ASTNode>& node, BodyInfo& info) {
+    if (!node) return;
+
+    switch (node->kind) {
+        case NodeKind::Call:
+            info.calls.insert(node->sym);
+            info.names.insert(node->sym);
+            break;
+
+        case NodeKind::Identifier:
+        case NodeKind::VarDecl:
+        case NodeKind::ArrayDecl:
+            info.names.insert(node->sym);
+            break;
+
+        case NodeKind::ForIn:
+            info.names.insert(node->sym);
+            [[fallthrough]];
+        case NodeKind::While:
+            // "-> var": letta per nome dopo ogni iterazione
+            if (node->returnVar != NO_SYMBOL)
+                info.names.insert(node->returnVar);
+            break;
+
+        case NodeKind::ArrayAccess:
+            if (!node->value.empty()) info.names.insert(node->sym);
+            break;
+
+        default:
+            break;
+    }
+
+    for (auto& ch : node->children) collectNames(ch, info);
+}
+
+// Chiusura transitiva sulle chiamate per nome: la funzione chiamata
+// cattura dallo scope del chiamante, quindi le sue variabili libere
+// devono essere disponibili anche lì
+void Resolver::computeCaptures() {
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (auto& info : bodies) {
+            for (auto& callee : info.calls) {
+                auto it = defsByName.find(callee);
+                if (it == defsByName.end()) continue;
+                for (size_t idx : it->second) {
+                    if (&bodies[idx] == &info) continue;
+                    for (auto& name : bodies[idx].names) {
+                        if (info.names.insert(name).second) changed = true;
+                    }
+                }
+            }
+        }
+    }
+}
+
+// ============================================================
+// Dichiarazioni: tutto ciò che può finire nello scope del frame
+// ============================================================
+void Resolver::declare(const std::shared_ptr<ASTNode>& node, FrameLayout& layout) {
+    if (!node) return;
+
+    switch (node->kind) {
+        case NodeKind::VarDecl:
+        case NodeKind::ArrayDecl:
+        case NodeKind::ForIn:
+            layout.add(node->sym);
+            break;
+
+        case NodeKind::Assign:
+            if (!node->children.empty() && node->children[0] &&
+                node->children[0]->kind == NodeKind::Identifier)
+                layout.add(node->children[0]->sym);
+            break;
+
+        // Frame annidati: hanno il proprio layout
+        case NodeKind::FunctionDef:
+        case NodeKind::Lambda:
+            return;
+
+        case NodeKind::Filter:
+            // Solo l'array di partenza è valutato in questo frame
+            if (!node->children.empty()) declare(node->children[0], layout);
+            return;
+
+        default:
+            break;
+    }
+
+    for (auto& ch : node->children) declare(ch, layout);
+}
+
+// ============================================================
+// Riferimenti
+// ============================================================
+void Resolver::bind(ASTNode& node) {
+    for (int i = static_cast<int>(frames.size()) - 1; i >= 0; --i) {
+        int slot = frames[i].layout->slotOf(node.sym);
+        if (slot >= 0) {
+            node.slot = slot;
+            node.depth = static_cast<int>(frames.size()) - 1 - i;
+            return;
+        }
+        if (!frames[i].transparent) break;
+    }
+    node.slot = -1;
+    node.depth = 0;
+}
+
+void Resolver::visit(const std::shared_ptr<ASTNode>& node) {
+    if (!node) return;
+
+    switch (node->kind) {
+        case NodeKind::Call:
+            node->callSite = callSites++;
+            if (node->builtin >= 0 && !boundNames.count(node->sym))
+                node->builtinOnly = true;
+            [[fallthrough]];
+        case NodeKind::Identifier:
+        case NodeKind::VarDecl:
+        case NodeKind::ArrayDecl:
+        case NodeKind::ForIn:
+            bind(*node);
+            break;
+
+        case NodeKind::ArrayAccess:
+            // Formato varname[index]: il nome è in value
+            if (!node->value.empty()) bind(*node);
+            break;
+
+        case NodeKind::FunctionDef: {
+            std::vector<Symbol> params;
+            for (auto& ch : node->children) {
+                if (!ch) continue;
+                if (ch->kind == NodeKind::Param) {
+                    params.push_back(ch->sym);
+                } else if (ch->kind == NodeKind::Body) {
+                    resolveFrame(ch, ch, params, false);
+                    markTail(ch);
+                }
+            }
+            return;
+        }
+
+        case NodeKind::Lambda: {
+            std::vector<Symbol> params;
+            for (auto& ch : node->children) {
+                if (!ch) continue;
+                if (ch->kind == NodeKind::Param) {
+                    params.push_back(ch->sym);
+                } else {
+                    resolveFrame(ch, ch, params, false);
+                    markTail(ch);
+                    break;
+                }
+            }
+            return;
+        }
+
+        case NodeKind::Assign:
+            node->append = appendPieces(*node);
+            break;
+
+        case NodeKind::Filter:
+            if (node->children.size() < 2) break;
+            visit(node->children[0]);
+            resolveFrame(node->children[1], node->children[1], {filterItem}, true);
+            for (size_t i = 2; i < node->children.size(); ++i)
+                visit(node->children[i]);
+            // Dopo visit: le Call del predicato hanno già builtinOnly
+            node->pure = isPure(node->children[1]);
+            return;
+
+        default:
+            break;
+    }
+
+    for (auto& ch : node->children) visit(ch);
+}
+
+// ============================================================
+// Append: s = s $ a $ b → Concat(Concat(s, a), b), pezzi a e b
+// (lo slice s $[i:j] resta al caso generale)
+// ============================================================
+int Resolver::appendPieces(const ASTNode& assign) {
+    if (assign.children.size() < 2 || !assign.children[0] ||
+        assign.children[0]->kind != NodeKind::Identifier)
+        return 0;
+
+    int pieces = 0;
+    const ASTNode* link = assign.children[1].get();
+    while (link && link->kind == NodeKind::BinaryOp && link->op == Operator::Concat &&
+           link->children.size() == 2 && link->children[1] &&
+           link->children[1]->kind != NodeKind::RangeExpr) {
+        ++pieces;
+        link = link->children[0].get();
+    }
+
+    if (!link || link->kind != NodeKind::Identifier ||
+        link->sym != assign.children[0]->sym)
+        return 0;
+    return pieces;
+}
+
+// ============================================================
+// Posizioni di coda (TCO)
+// ============================================================
+void Resolver::markTail(const std::shared_ptr<ASTNode>& node) {
+    if (!node) return;
+
+    switch (node->kind) {
+        case NodeKind::Call:
+        case NodeKind::CallExpr:
+            node->tail = true;
+            return;
+
+        case NodeKind::Body: {
+            // Il valore del Body è l'ultimo statement solo se è un'espressione
+            std::shared_ptr<ASTNode> last;
+            for (auto& st : node->children)
+                if (st) last = st;
+            if (last && last->kind == NodeKind::ExprStmt && !last->children.empty())
+                markTail(last->children[0]);
+            return;
+        }
+
+        case NodeKind::IfExpr: {
+            // [cond, then, (cond, body)*, else?]
+            int elifCount = node->extra.count("elifCount")
+                            ? std::stoi(node->extra.at("elifCount")) : 0;
+            bool hasElse = node->extra.count("hasElse") &&
+                           node->extra.at("hasElse") == "true";
+            size_t end = 2 + 2 * static_cast<size_t>(elifCount);
+            for (size_t i = 1; i < end && i < node->children.size(); i += 2)
+                markTail(node->children[i]);
+            if (hasElse && end < node->children.size())
+                markTail(node->children[end]);
+            return;
+        }
+
+        case NodeKind::CondChain: {
+            bool hasFallback = node->extra.count("hasFallback") &&
+                               node->extra.at("hasFallback") == "1";
+            size_t n = node->children.size();
+            size_t limit = (hasFallback && n > 0) ? n - 1 : n;
+            for (size_t i = 0; i < limit; ++i) {
+                auto& cond = node->children[i];
+                if (cond && cond->kind == NodeKind::SimpleCond && cond->children.size() >= 2)
+                    markTail(cond->children[1]);
+            }
+            if (hasFallback && n > 0) markTail(node->children[n - 1]);
+            return;
+        }
+
+        default:
+            return;
+    }
+}
+
+// ============================================================
+// Purezza (filter paralleli)
+// ============================================================
+bool Resolver::isPure(const std::shared_ptr<ASTNode>& node) const {
+    if (!node) return true;
+
+    switch (node->kind) {
+        case NodeKind::Literal:
+        case NodeKind::Identifier:
+        case NodeKind::BinaryOp:
+        case NodeKind::LogicalOp:
+        case NodeKind::UnaryOp:
+        case NodeKind::CondChain:
+        case NodeKind::SimpleCond:
+        case NodeKind::Elvis:
+        case NodeKind::IfExpr:
+        case NodeKind::Body:
+        case NodeKind::ExprStmt:
+        case NodeKind::ArrayAccess:
+        case NodeKind::RangeExpr:
+        case NodeKind::Slice:
+        case NodeKind::Filter:
+            break;
+
+        case NodeKind::Call:
+            // Solo builtin che non possono essere nascosti e non toccano
+            // stato condiviso (niente random, input o modifiche agli array)
+            if (!node->builtinOnly) return false;
+            switch (static_cast<BuiltinId>(node->builtin)) {
+                case BuiltinId::Str:
+                case BuiltinId::Len:
+                case BuiltinId::ArrayLength:
+                case BuiltinId::ArrayFirst:
+                case BuiltinId::ArrayLast:
+                case BuiltinId::ToInt:
+                case BuiltinId::ToDouble:
+                case BuiltinId::TypeOf:
+                case BuiltinId::Range:
+                    break;
+                default:
+                    return false;
+            }
+            break;
+
+        default:
+            return false;
+    }
+
+    for (auto& ch : node->children)
+        if (!isPure(ch)) return false;
+    return true;
+}
+
+// ============================================================
+// Def pure e memoizzazione
+// ============================================================
+void Resolver::computePurity() {
+    size_t n = bodies.size();
+    std::vector<char> pure(n, 0);
+    std::vector<std::set<Symbol>> callees(n);
+
+    // 1) Controllo locale: il body usa solo parametri e variabili proprie
+    for (size_t i = 0; i < n; ++i) {
+        if (!bodies[i].isDef) continue;
+        std::set<Symbol> locals = bodies[i].params;
+        collectLocals(bodies[i].body, locals);
+        pure[i] = isPureBody(bodies[i].body, locals, callees[i]);
+    }
+
+    // 2) Punto fisso: una def chiamata per nome deve essere pura e unica
+    // nel programma (il lookup è dinamico: con più def omonime la stessa
+    // chiamata può risolvere a def diverse e gli argomenti non bastano
+    // più a determinare il risultato); il nome non può essere una variabile
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t i = 0; i < n; ++i) {
+            if (!pure[i]) continue;
+            for (auto& name : callees[i]) {
+                auto it = defsByName.find(name);
+                bool ok = it != defsByName.end() && it->second.size() == 1 &&
+                          !varNames.count(name) && pure[it->second[0]];
+                if (!ok) {
+                    pure[i] = 0;
+                    changed = true;
+                    break;
+                }
+            }
+        }
+    }
+
+    // 3) Memo solo per le def pure ricorsive (direttamente o in un ciclo
+    // di chiamate): sono quelle che ricalcolano gli stessi argomenti
+    for (size_t i = 0; i < n; ++i) {
+        if (!pure[i]) continue;
+        bodies[i].body->pure = true;
+
+        std::vector<char> seen(n, 0);
+        std::vector<size_t> stack{i};
+        bool recursive = false;
+        while (!stack.empty() && !recursive) {
+            size_t cur = stack.back();
+            stack.pop_back();
+            for (auto& name : callees[cur]) {
+                for (size_t j : defsByName.at(name)) {
+                    if (j == i) recursive = true;
+                    if (!seen[j]) {
+                        seen[j] = 1;
+                        stack.push_back(j);
+                    }
+                }
+            }
+        }
+
+        if (recursive) bodies[i].body->memo = memoTables++;
+        DEBUG_INTERP_LOG("Resolver: def pura" << (recursive ? " ricorsiva (memo)" : ""));
+    }
+}
+
+// Variabili dichiarate nel body (senza entrare in funzioni/lambda annidate)
+void Resolver::collectLocals(const std::shared_ptr<ASTNode>& node,
+                             std::set<Symbol>& locals) const {
+    if (!node) return;
+
+    switch (node->kind) {
+        case NodeKind::VarDecl:
+        case NodeKind::ArrayDecl:
+        case NodeKind::ForIn:
+            locals.insert(node->sym);
+            break;
+
+        case NodeKind::FunctionDef:
+        case NodeKind::Lambda:
+            return;
+
+        default:
+            break;
+    }
+
+    for (auto& ch : node->children) collectLocals(ch, locals);
+}
+
+bool Resolver::isPureBody(const std::shared_ptr<ASTNode>& node,
+                          const std::set<Symbol>& locals,
+                          std::set<Symbol>& callees) const {
+    if (!node) return true;
+
+    switch (node->kind) {
+        // Effetti visibili o funzioni di cui non si conosce il corpo
+        case NodeKind::Echo:
+        case NodeKind::FunctionDef:
+        case NodeKind::Lambda:
+        case NodeKind::CallExpr:
+            return false;
+
+        case NodeKind::Identifier:
+            if (!locals.count(node->sym)) return false;
+            break;
+
+        case NodeKind::ArrayAccess:
+            if (!node->value.empty() && !locals.count(node->sym)) return false;
+            break;
+
+        case NodeKind::ForIn:
+        case NodeKind::While:
+            if (node->returnVar != NO_SYMBOL && !locals.count(node->returnVar))
+                return false;
+            break;
+
+        case NodeKind::Assign:
+            // Un nome non dichiarato nel body aggiornerebbe lo scope del chiamante
+            if (node->children.empty() || !node->children[0] ||
+                node->children[0]->kind != NodeKind::Identifier ||
+                !locals.count(node->children[0]->sym))
+                return false;
+            break;
+
+        case NodeKind::Filter: {
+            if (node->children.size() < 2) break;
+            std::set<Symbol> inner = locals;
+            inner.insert(filterItem);
+            return isPureBody(node->children[0], locals, callees) &&
+                   isPureBody(node->children[1], inner, callees);
+        }
+
+        case NodeKind::Call:
+            if (locals.count(node->sym)) return false;     // variabile funzione
+            if (node->builtinOnly) {
+                switch (static_cast<BuiltinId>(node->builtin)) {
+                    case BuiltinId::Input:
+                    case BuiltinId::RandInt:
+                    case BuiltinId::RandDouble:
+                        return false;
+                    case BuiltinId::ArrayPush:
+                    case BuiltinId::ArrayPop:
+                        // Modificano l'array nominato: ammesso solo se locale
+                        if (node->children.empty() || !node->children[0] ||
+                            node->children[0]->kind != NodeKind::Identifier ||
+                            !locals.count(node->children[0]->sym))
+                            return false;
+                        break;
+                    default:
+                        break;
+                }
+            } else {
+                callees.insert(node->sym);
+            }
+            break;
+
+        default:
+            break;
+    }
+
+    for (auto& ch : node->children)
+        if (!isPureBody(ch, locals, callees)) return false;
+    return true;
+}
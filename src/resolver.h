@@ -0,0 +1,115 @@
+#ifndef MAMMUTH_RESOLVER_H
+#define MAMMUTH_RESOLVER_H
+
+#include <memory>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "ast.h"
+#include "scope.h"
+
+// ============================================================
+// Resolver: passata statica dopo il parsing.
+// Ogni frame (programma, body di funzione/lambda, predicato di
+// filter) riceve un FrameLayout con le sue variabili locali;
+// i nodi che nominano una variabile ricevono (depth, slot).
+//
+// Gli scope restano dinamici (le chiamate vedono lo scope del
+// chiamante e le variabili catturate), quindi la risoluzione si
+// ferma al frame di funzione/programma: ciò che non è nel suo
+// layout resta un lookup per nome. Solo i frame di filter sono
+// attraversati (depth > 0), perché il loro scope contiene
+// esclusivamente le variabili del loro layout.
+//
+// Per le closure calcola anche le variabili libere di ogni body
+// di funzione/lambda (FrameLayout::captures): i nomi usati nel
+// body, nelle funzioni/lambda annidate e, transitivamente, nelle
+// funzioni chiamate per nome (che vedono lo scope del chiamante).
+//
+// Infine marca le chiamate in posizione di coda dei body di
+// funzione/lambda (ASTNode::tail), eseguite dall'Interpreter
+// senza ricorsione (TCO), e i filter con predicato puro
+// (ASTNode::pure), che l'Interpreter può dividere tra più thread.
+//
+// Marca gli assegnamenti "s = s $ ..." (ASTNode::append), che
+// l'Interpreter esegue aggiungendo in coda alla stringa di s.
+//
+// Classifica le def pure (niente echo, input, random, né letture o
+// scritture fuori da parametri e variabili locali; chiamano solo
+// builtin puri e def pure): quelle ricorsive ricevono una tabella
+// di memo (ASTNode::memo).
+// ============================================================
+class Resolver {
+public:
+    void resolve(const std::shared_ptr<ASTNode>& program);
+
+private:
+    struct Frame {
+        FrameLayout* layout;
+        bool transparent;   // frame di filter: si può risalire al padre
+    };
+    std::vector<Frame> frames;
+    int callSites = 0;      // Call per nome numerate (ASTNode::callSite)
+    int memoTables = 0;     // def memoizzate (ASTNode::memo)
+    const Symbol filterItem = internSymbol("x");     // variabile dei predicati di filter
+
+    // Variabili libere dei body di funzione/lambda
+    struct BodyInfo {
+        std::shared_ptr<ASTNode> body;
+        bool isDef = false;             // body di FunctionDef (non lambda)
+        std::set<Symbol> params;
+        std::set<Symbol> names;    // nomi usati (anche in frame annidati)
+        std::set<Symbol> calls;    // funzioni chiamate per nome
+    };
+    std::vector<BodyInfo> bodies;
+    std::unordered_map<const ASTNode*, size_t> bodyIndex;
+    std::unordered_map<Symbol, std::vector<size_t>> defsByName;
+
+    // Nomi che possono diventare variabili o def in qualche punto del
+    // programma (le Call a builtin con altri nomi non sono mai nascoste)
+    std::set<Symbol> boundNames;
+    std::set<Symbol> varNames;     // solo variabili e parametri (non def)
+    void collectBound(const std::shared_ptr<ASTNode>& node);
+
+    void collectBodies(const std::shared_ptr<ASTNode>& node);
+    void addBody(const std::shared_ptr<ASTNode>& body,
+                 const std::vector<Symbol>& params,
+                 Symbol funcName);
+    void collectNames(const std::shared_ptr<ASTNode>& node, BodyInfo& info);
+    void computeCaptures();
+
+    // Apre il frame di 'owner' (params già dichiarati) e risolve 'body'
+    void resolveFrame(const std::shared_ptr<ASTNode>& owner,
+                      const std::shared_ptr<ASTNode>& body,
+                      const std::vector<Symbol>& params,
+                      bool transparent);
+
+    // Prima passata: nomi definiti nel frame (senza entrare nei frame annidati)
+    void declare(const std::shared_ptr<ASTNode>& node, FrameLayout& layout);
+
+    // Seconda passata: assegna (depth, slot) ai riferimenti
+    void visit(const std::shared_ptr<ASTNode>& node);
+    void bind(ASTNode& node);
+
+    // "s = s $ a $ b": numero di pezzi della catena di '$' (0 = altro)
+    static int appendPieces(const ASTNode& assign);
+
+    // Chiamate in coda: il loro valore è direttamente quello del body
+    void markTail(const std::shared_ptr<ASTNode>& node);
+
+    // Espressione senza effetti collaterali: legge solo variabili e
+    // chiama solo builtin puri (predicati di filter paralleli)
+    bool isPure(const std::shared_ptr<ASTNode>& node) const;
+
+    // Def pure: controllo locale del body, poi punto fisso sulle chiamate
+    void computePurity();
+    bool isPureBody(const std::shared_ptr<ASTNode>& node,
+                    const std::set<Symbol>& locals,
+                    std::set<Symbol>& callees) const;
+    void collectLocals(const std::shared_ptr<ASTNode>& node,
+                       std::set<Symbol>& locals) const;
+};
+
+#endif // MAMMUTH_RESOLVER_H
@@ -1,9 +1,13 @@
 #ifndef MAMMUTH_SCOPE_H
 #define MAMMUTH_SCOPE_H
 
+#include <algorithm>
 #include <unordered_map>
 #include <string>
+#include <vector>
 #include <memory>
+#include <cstdint>
+#include "symbols.h"
 #include "value.h"
 
 // Forward declaration
@@ -15,30 +19,151 @@ struct StoredVar {
     bool isFixed = false;    // Per variabili fixed (immutabili)
 };
 
+// ============================================
+// Layout statico di un frame (calcolato dal Resolver):
+// simbolo della variabile → indice di slot.
+// Un frame è il body di una funzione/lambda, il programma
+// oppure il predicato di un filter.
+// ============================================
+struct FrameLayout {
+    std::vector<Symbol> names;
+    std::unordered_map<Symbol, int> index;
+    std::vector<int> captures;  // slot delle variabili libere (closure)
+
+    int size() const { return static_cast<int>(names.size()); }
+
+    int slotOf(Symbol n) const {
+        auto it = index.find(n);
+        return it != index.end() ? it->second : -1;
+    }
+
+    int add(Symbol n) {
+        auto it = index.find(n);
+        if (it != index.end()) return it->second;
+        int slot = size();
+        names.push_back(n);
+        index[n] = slot;
+        return slot;
+    }
+};
+
 class Scope {
 public:
-    std::unordered_map<std::string, StoredVar> vars;
-    std::unordered_map<std::string, std::shared_ptr<ASTNode>> localFunctions;  // ← NUOVO!
+    std::unordered_map<Symbol, StoredVar> vars;
+    std::unordered_map<Symbol, std::shared_ptr<ASTNode>> localFunctions;  // ← NUOVO!
     Scope* parent = nullptr;
 
-    Scope(Scope* p = nullptr) : parent(p) {}
+    // Variabili del layout: un nome presente nel layout vive SOLO nel suo slot
+    // (mai in vars); bound[i] dice se lo slot è stato definito.
+    const FrameLayout* layout = nullptr;
+    std::vector<StoredVar> slots;
+    std::vector<uint8_t> bound;
 
-    bool existsLocal(const std::string& n) const {
-        return vars.count(n) > 0;
+    Scope(Scope* p = nullptr, const FrameLayout* l = nullptr) : parent(p) {
+        setLayout(l);
     }
 
-    StoredVar* lookup(const std::string& n) {
+    // Adotta un layout: le variabili già definite per nome passano negli slot
+    void setLayout(const FrameLayout* l) {
+        layout = l;
+        int n = l ? l->size() : 0;
+        slots.assign(n, StoredVar{});
+        bound.assign(n, 0);
+        if (vars.empty()) return;
+        for (int i = 0; i < n; ++i) {
+            auto it = vars.find(l->names[i]);
+            if (it == vars.end()) continue;
+            slots[i] = std::move(it->second);
+            bound[i] = 1;
+            vars.erase(it);
+        }
+    }
+
+    // ============================================
+    // Riuso dal pool dell'Interpreter: nessuna allocazione
+    // (le mappe e i vettori conservano la loro capacità)
+    // ============================================
+    void reset(Scope* p, const FrameLayout* l) {
+        parent = p;
+        setLayout(l);
+    }
+
+    // Riuso sul posto (elementi/stadi di filter): come uno scope appena
+    // aperto con layout l, senza passare dal pool
+    void renew(const FrameLayout* l) {
+        if (!vars.empty()) vars.clear();
+        if (!localFunctions.empty()) localFunctions.clear();
+        if (l == layout) {
+            // Stesso layout: basta dimenticare gli slot (valori sovrascritti al define)
+            std::fill(bound.begin(), bound.end(), 0);
+            return;
+        }
+        setLayout(l);
+    }
+
+    // Rilascia subito i valori contenuti (lo scope torna nel pool)
+    void release() {
+        vars.clear();
+        localFunctions.clear();
+        slots.clear();
+        bound.clear();
+        layout = nullptr;
+        parent = nullptr;
+    }
+
+    StoredVar* findLocal(Symbol n) {
+        if (layout) {
+            int slot = layout->slotOf(n);
+            if (slot >= 0) return bound[slot] ? &slots[slot] : nullptr;
+        }
         auto it = vars.find(n);
-        if (it != vars.end()) return &it->second;
-        if (parent) return parent->lookup(n);
+        return it != vars.end() ? &it->second : nullptr;
+    }
+
+    bool existsLocal(Symbol n) {
+        return findLocal(n) != nullptr;
+    }
+
+    StoredVar* lookup(Symbol n) {
+        for (Scope* s = this; s; s = s->parent) {
+            if (StoredVar* sv = s->findLocal(n)) return sv;
+        }
         return nullptr;
     }
 
-    void define(const std::string& n, const StoredVar& v) {
+    void define(Symbol n, const StoredVar& v) {
+        if (layout) {
+            int slot = layout->slotOf(n);
+            if (slot >= 0) {
+                defineSlot(slot, v);
+                return;
+            }
+        }
         vars[n] = v;
     }
 
-    void set(const std::string& n, const Value& val) {
+    // Accesso diretto per slot (indici risolti dal Resolver)
+    StoredVar* slotAt(int slot) {
+        if (slot < 0 || slot >= static_cast<int>(slots.size()) || !bound[slot])
+            return nullptr;
+        return &slots[slot];
+    }
+
+    void defineSlot(int slot, const StoredVar& v) {
+        slots[slot] = v;
+        bound[slot] = 1;
+    }
+
+    // Visita tutte le variabili definite (slot + per nome)
+    template<typename F>
+    void forEachVar(F&& f) const {
+        for (size_t i = 0; i < slots.size(); ++i) {
+            if (bound[i]) f(layout->names[i], slots[i]);
+        }
+        for (const auto& pair : vars) f(pair.first, pair.second);
+    }
+
+    void set(Symbol n, const Value& val) {
         StoredVar* sv = lookup(n);
         if (!sv) return;
         sv->value = val;
@@ -47,11 +172,11 @@ public:
     // ============================================
     // NUOVO: Gestione funzioni locali (nested)
     // ============================================
-    void defineLocalFunction(const std::string& name, std::shared_ptr<ASTNode> funcNode) {
+    void defineLocalFunction(Symbol name, std::shared_ptr<ASTNode> funcNode) {
         localFunctions[name] = funcNode;
     }
     
-    std::shared_ptr<ASTNode> lookupLocalFunction(const std::string& name) {
+    std::shared_ptr<ASTNode> lookupLocalFunction(Symbol name) {
         auto it = localFunctions.find(name);
         if (it != localFunctions.end()) return it->second;
         if (parent) return parent->lookupLocalFunction(name);
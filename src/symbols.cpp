@@ -0,0 +1,59 @@
+#include "symbols.h"
+
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+
+namespace {
+
+// I nomi vivono in una deque (indirizzi stabili): le chiavi della
+// mappa sono viste sui nomi stessi, senza una seconda copia
+struct SymbolTable {
+    std::mutex lock;
+    std::deque<std::string> names;
+    std::unordered_map<std::string_view, Symbol> ids;
+};
+
+SymbolTable& table() {
+    static SymbolTable t;
+    return t;
+}
+
+// Chiamata con t.lock già acquisito
+Symbol internLocked(SymbolTable& t, std::string_view name) {
+    auto it = t.ids.find(name);
+    if (it != t.ids.end()) return it->second;
+
+    Symbol sym = static_cast<Symbol>(t.names.size());
+    t.names.emplace_back(name);
+    t.ids.emplace(t.names.back(), sym);
+    return sym;
+}
+
+} // namespace
+
+Symbol internSymbol(std::string_view name) {
+    SymbolTable& t = table();
+    std::lock_guard<std::mutex> guard(t.lock);
+    return internLocked(t, name);
+}
+
+const std::string& symbolName(Symbol sym) {
+    static const std::string none;
+    SymbolTable& t = table();
+    std::lock_guard<std::mutex> guard(t.lock);
+    if (sym < 0 || sym >= static_cast<Symbol>(t.names.size())) return none;
+    return t.names[sym];
+}
+
+SymbolBatch::SymbolBatch() {
+    table().lock.lock();
+}
+
+SymbolBatch::~SymbolBatch() {
+    table().lock.unlock();
+}
+
+Symbol SymbolBatch::intern(std::string_view name) {
+    return internLocked(table(), name);
+}
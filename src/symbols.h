@@ -0,0 +1,39 @@
+#ifndef MAMMUTH_SYMBOLS_H
+#define MAMMUTH_SYMBOLS_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// ============================================================
+// Simboli: tabella globale nome → id intero, riempita dal Lexer
+// con gli identificatori (i letterali restano fuori). Parser,
+// Resolver, scope e Interpreter usano l'id come chiave, così ogni
+// lookup per nome confronta e calcola l'hash di un intero. L'id di
+// un nome non cambia per tutta l'esecuzione; il testo si recupera
+// con symbolName (messaggi di errore, transpiler, debug).
+// ============================================================
+using Symbol = int32_t;
+
+constexpr Symbol NO_SYMBOL = -1;
+
+// Id del nome (lo aggiunge alla tabella se nuovo)
+Symbol internSymbol(std::string_view name);
+
+// Testo del simbolo ("" per NO_SYMBOL); il riferimento resta valido
+const std::string& symbolName(Symbol sym);
+
+// Inserimento di molti nomi di seguito (Lexer): la tabella resta
+// bloccata per tutta la vita dell'oggetto, un lock invece di uno
+// per nome. Nel frattempo non chiamare internSymbol/symbolName.
+class SymbolBatch {
+public:
+    SymbolBatch();
+    ~SymbolBatch();
+    SymbolBatch(const SymbolBatch&) = delete;
+    SymbolBatch& operator=(const SymbolBatch&) = delete;
+
+    Symbol intern(std::string_view name);
+};
+
+#endif // MAMMUTH_SYMBOLS_H
@@ -0,0 +1,57 @@
+#include "thread_pool.h"
+
+ThreadPool::ThreadPool(unsigned workers) {
+    threads.reserve(workers);
+    for (unsigned i = 0; i < workers; ++i)
+        threads.emplace_back(&ThreadPool::workerLoop, this);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& t : threads) t.join();
+}
+
+void ThreadPool::run(size_t tasks, const std::function<void(size_t)>& task) {
+    if (tasks == 0) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        job = &task;
+        nextTask = 1;
+        taskCount = tasks;
+        pending = tasks - 1;
+    }
+    wake.notify_all();
+
+    task(0);
+
+    // Indici non ancora presi dal pool: li esegue il chiamante
+    std::unique_lock<std::mutex> lock(mutex);
+    while (nextTask < taskCount) {
+        size_t i = nextTask++;
+        lock.unlock();
+        task(i);
+        lock.lock();
+        --pending;
+    }
+    done.wait(lock, [this] { return pending == 0; });
+    job = nullptr;
+}
+
+void ThreadPool::workerLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wake.wait(lock, [this] { return stopping || (job && nextTask < taskCount); });
+        if (stopping) return;
+
+        size_t i = nextTask++;
+        const auto& task = *job;
+        lock.unlock();
+        task(i);
+        lock.lock();
+        if (--pending == 0) done.notify_one();
+    }
+}
@@ -0,0 +1,41 @@
+#ifndef MAMMUTH_THREAD_POOL_H
+#define MAMMUTH_THREAD_POOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// ============================================================
+// Pool di thread persistente (filter paralleli, --threads):
+// i thread sono creati una volta sola e restano in attesa.
+// run(n, task) esegue task(0) .. task(n-1): il thread chiamante
+// prende l'indice 0 (e aiuta con quelli ancora liberi), i thread
+// del pool gli altri; ritorna quando sono tutti terminati.
+// ============================================================
+class ThreadPool {
+public:
+    explicit ThreadPool(unsigned workers);
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void run(size_t tasks, const std::function<void(size_t)>& task);
+
+private:
+    void workerLoop();
+
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable wake;       // nuovo lavoro o chiusura
+    std::condition_variable done;       // ultimo task terminato
+    const std::function<void(size_t)>* job = nullptr;
+    size_t nextTask = 0;
+    size_t taskCount = 0;
+    size_t pending = 0;                 // task 1..n-1 non ancora terminati
+    bool stopping = false;
+};
+
+#endif // MAMMUTH_THREAD_POOL_H
@@ -21,7 +21,7 @@ std::string CPPTranspiler::transpile(const std::shared_ptr<ASTNode>& ast) {
 
     auto body = ast->children[0];  // Body del Program
     for (auto& child : body->children) {
-        if (child->type == "FunctionDef") {
+        if (child->kind == NodeKind::FunctionDef) {
             functions += generateCode(child);
         } else {
             mainBody += "    " + generateCode(child);
@@ -41,60 +41,45 @@ std::string CPPTranspiler::transpile(const std::shared_ptr<ASTNode>& ast) {
 std::string CPPTranspiler::generateCode(const std::shared_ptr<ASTNode>& node) {
     if (!node) return "";
 
-    if (node->type == "Program") {
-        // Processa body
-        return generateCode(node->children[0]);
-
-    } else if (node->type == "Body") {
-        std::string code;
-        for (auto& child : node->children) {
-            code += "    " + generateCode(child);
+    switch (node->kind) {
+        case NodeKind::Program:
+            // Processa body
+            return generateCode(node->children[0]);
+
+        case NodeKind::Body: {
+            std::string code;
+            for (auto& child : node->children) {
+                code += "    " + generateCode(child);
+            }
+            return code;
         }
-        return code;
-
-    } else if (node->type == "Echo") {
-        return generateEcho(node);
-
-    } else if (node->type == "Literal") {
-        return generateLiteral(node);
-
-    } else if (node->type == "VarDecl") {
-        return generateVarDecl(node);
-    }else if (node->type == "Identifier") {
-        return generateIdentifier(node);
-    }else if (node->type == "BinaryOp") {
-        return generateBinaryOp(node);
-    } else if (node->type == "IfExpr") {
-        return generateIfExpression(node);
-    } else if (node->type == "ExprStmt") {
-        return generateCode(node->children[0]);
-    }else if (node->type == "While") {
-        return generateWhileLoop(node);
-    }else if (node->type == "Assign") {
-        return generateAssignment(node);
-    }else if (node->type == "ForIn") {
-        return generateForLoop(node);
-    }else if (node->type == "ArrayDecl") {
-        return generateArrayDecl(node);
-    } else if (node->type == "ArrayInit") {
-        return generateArrayInit(node);
-    }else if (node->type == "CommaList") {
-        return generateCommaList(node);
-    } else if (node->type == "FunctionDef") {
-        return generateFunctionDef(node);
-    } else if (node->type == "Call") {
-        return generateFunctionCall(node);
-    }else if (node->type == "UnaryOp") {
-        return generateUnaryOp(node);
-    }else if (node->type == "ArrayAccess") {
-        return generateArrayAccess(node);
-    }else if (node->type == "CondChain") {
-        return generateCondChain(node);
-    }else if (node->type == "Filter") {
-        return generateFilter(node);
-    }
-    else {
-        throw std::runtime_error("Tipo non gestito: " + node->type);
+
+        case NodeKind::Echo:        return generateEcho(node);
+        case NodeKind::Literal:     return generateLiteral(node);
+        case NodeKind::VarDecl:     return generateVarDecl(node);
+        case NodeKind::Identifier:  return generateIdentifier(node);
+        case NodeKind::BinaryOp:    return generateBinaryOp(node);
+        case NodeKind::IfExpr:      return generateIfExpression(node);
+        case NodeKind::ExprStmt:
+            // if con ramo costante ridotto dall'Optimizer al suo Body: resta un blocco
+            if (node->children[0]->kind == NodeKind::Body)
+                return "{\n" + generateCode(node->children[0]) + "    }\n";
+            return generateCode(node->children[0]);
+        case NodeKind::While:       return generateWhileLoop(node);
+        case NodeKind::Assign:      return generateAssignment(node);
+        case NodeKind::ForIn:       return generateForLoop(node);
+        case NodeKind::ArrayDecl:   return generateArrayDecl(node);
+        case NodeKind::ArrayInit:   return generateArrayInit(node);
+        case NodeKind::CommaList:   return generateCommaList(node);
+        case NodeKind::FunctionDef: return generateFunctionDef(node);
+        case NodeKind::Call:        return generateFunctionCall(node);
+        case NodeKind::UnaryOp:     return generateUnaryOp(node);
+        case NodeKind::ArrayAccess: return generateArrayAccess(node);
+        case NodeKind::CondChain:   return generateCondChain(node);
+        case NodeKind::Filter:      return generateFilter(node);
+
+        default:
+            throw std::runtime_error("Tipo non gestito: " + node->type);
     }
 }
 
@@ -269,7 +254,7 @@ std::string CPPTranspiler::generateEcho(const std::shared_ptr<ASTNode>& node) {
 std::string CPPTranspiler::generateAssignment(const std::shared_ptr<ASTNode>& node) {
     // Check TIPO senza generare codice
     if (node->children.size() > 0 &&
-        node->children[0]->type == "ArrayAccess") {
+        node->children[0]->kind == NodeKind::ArrayAccess) {
 
         std::string arrayAccess = generateCode(node->children[0]);
         std::string value = generateCode(node->children[1]);
@@ -352,7 +337,7 @@ std::string CPPTranspiler::generateCommaList(const std::shared_ptr<ASTNode>& nod
 std::string CPPTranspiler::generateArrayInit(const std::shared_ptr<ASTNode>& node) {
     // Se contiene un solo ArrayAccess, non wrappare con graffe
     if (node->children.size() == 1 &&
-        node->children[0]->type == "ArrayAccess") {
+        node->children[0]->kind == NodeKind::ArrayAccess) {
         return generateCode(node->children[0]);
     }
 
@@ -372,11 +357,11 @@ std::string CPPTranspiler::generateArrayDecl(const std::shared_ptr<ASTNode>& nod
     bool isDynamic = node->extra.count("dynamic") &&
                      node->extra.at("dynamic") == "true";
     std::string values = generateCode(node->children[0]);
-    bool isSlice = node->children[0]->type == "ArrayInit" &&
+    bool isSlice = node->children[0]->kind == NodeKind::ArrayInit &&
                node->children[0]->children.size() > 0 &&
-               node->children[0]->children[0]->type == "ArrayAccess" &&
+               node->children[0]->children[0]->kind == NodeKind::ArrayAccess &&
                node->children[0]->children[0]->children.size() > 0 &&
-               node->children[0]->children[0]->children.back()->type == "RangeExpr";
+               node->children[0]->children[0]->children.back()->kind == NodeKind::RangeExpr;
 
     // Array slicing returns dynamic array (std::vector)
     if (isDynamic || isSlice) {
@@ -390,7 +375,7 @@ std::string CPPTranspiler::generateArrayDecl(const std::shared_ptr<ASTNode>& nod
 }
 
 size_t CPPTranspiler::countArraySize(const std::shared_ptr<ASTNode>& node) {
-    if (node->type == "ArrayInit" && !node->children.empty()) {
+    if (node->kind == NodeKind::ArrayInit && !node->children.empty()) {
         auto commaList = node->children[0];
         return commaList->children.size();
     }
@@ -403,7 +388,7 @@ std::string CPPTranspiler::generateArrayAccess(const std::shared_ptr<ASTNode>& n
     size_t idxPos = node->value.empty() ? 1 : 0;
     auto indexNode = node->children[idxPos];
 
-    if (indexNode->type == "RangeExpr") {
+    if (indexNode->kind == NodeKind::RangeExpr) {
         return generateSlice(array, indexNode);
     }
 
@@ -5,12 +5,201 @@
 #include <vector>
 #include <stdexcept>
 #include <cstdint>
+#include <cstring>
+
+// Kernel SSE2/AVX2 solo con GCC/Clang su x86-64 (AVX2 scelto a runtime)
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+#define MAMMUTH_UTF8_SIMD 1
+#include <immintrin.h>
+#else
+#define MAMMUTH_UTF8_SIMD 0
+#endif
 
 // Eccezione per errori UTF-8
 struct Utf8Error : public std::runtime_error {
     using std::runtime_error::runtime_error;
 };
 
+// ============================================================
+// Kernel vettoriali
+// asciiPrefix: byte ASCII iniziali (salta le sequenze ASCII a
+// blocchi di 16/32 byte). countLeads: byte che iniziano un
+// codepoint, cioè il numero di codepoint di un testo valido.
+// Ogni kernel ha una versione scalare, SSE2 e AVX2; la tabella
+// è scelta una volta in base alla CPU.
+// ============================================================
+namespace utf8_kernels {
+
+inline size_t asciiPrefixScalar(const unsigned char* p, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        uint64_t w;
+        std::memcpy(&w, p + i, 8);
+        if (w & 0x8080808080808080ULL) break;
+    }
+    while (i < n && p[i] < 0x80) ++i;
+    return i;
+}
+
+inline size_t countLeadsScalar(const unsigned char* p, size_t n) {
+    size_t count = 0;
+    for (size_t i = 0; i < n; ++i)
+        count += (p[i] & 0xC0) != 0x80;
+    return count;
+}
+
+#if MAMMUTH_UTF8_SIMD
+inline size_t asciiPrefixSse2(const unsigned char* p, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+        int mask = _mm_movemask_epi8(v);
+        if (mask) return i + static_cast<size_t>(__builtin_ctz(static_cast<unsigned>(mask)));
+    }
+    return i + asciiPrefixScalar(p + i, n - i);
+}
+
+// Continuazioni = 0x80..0xBF, cioè -128..-65 come byte con segno
+inline size_t countLeadsSse2(const unsigned char* p, size_t n) {
+    const __m128i cont = _mm_set1_epi8(-65);
+    size_t count = 0, i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpgt_epi8(v, cont)));
+        count += static_cast<size_t>(__builtin_popcount(mask));
+    }
+    return count + countLeadsScalar(p + i, n - i);
+}
+
+__attribute__((target("avx2")))
+inline size_t asciiPrefixAvx2(const unsigned char* p, size_t n) {
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(v));
+        if (mask) return i + static_cast<size_t>(__builtin_ctz(mask));
+    }
+    return i + asciiPrefixSse2(p + i, n - i);
+}
+
+__attribute__((target("avx2")))
+inline size_t countLeadsAvx2(const unsigned char* p, size_t n) {
+    const __m256i cont = _mm256_set1_epi8(-65);
+    size_t count = 0, i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpgt_epi8(v, cont)));
+        count += static_cast<size_t>(__builtin_popcount(mask));
+    }
+    return count + countLeadsSse2(p + i, n - i);
+}
+#endif
+
+struct Table {
+    const char* name;
+    size_t (*asciiPrefix)(const unsigned char*, size_t);
+    size_t (*countLeads)(const unsigned char*, size_t);
+};
+
+inline Table scalarTable() {
+    return { "scalar", asciiPrefixScalar, countLeadsScalar };
+}
+
+inline Table selectTable() {
+#if MAMMUTH_UTF8_SIMD
+    if (__builtin_cpu_supports("avx2"))
+        return { "avx2", asciiPrefixAvx2, countLeadsAvx2 };
+    return { "sse2", asciiPrefixSse2, countLeadsSse2 };
+#else
+    return scalarTable();
+#endif
+}
+
+inline const Table& active() {
+    static const Table table = selectTable();
+    return table;
+}
+
+} // namespace utf8_kernels
+
+// Byte ASCII all'inizio di [p, p + n)
+inline size_t utf8AsciiPrefix(const unsigned char* p, size_t n) {
+    return utf8_kernels::active().asciiPrefix(p, n);
+}
+
+// Codepoint in [p, p + n) (precondizione: UTF-8 valido)
+inline size_t utf8CountCodepoints(const unsigned char* p, size_t n) {
+    return utf8_kernels::active().countLeads(p, n);
+}
+
+// Posizione del k-esimo codepoint dopo p (p inizia un codepoint di un
+// testo valido; end se il testo finisce prima)
+inline const unsigned char* utf8Advance(const unsigned char* p, const unsigned char* end, size_t k) {
+    size_t need = k + 1;    // inizi di codepoint da trovare, p compreso
+    while (static_cast<size_t>(end - p) >= 32) {
+        size_t leads = utf8CountCodepoints(p, 32);
+        if (leads >= need) break;
+        need -= leads;
+        p += 32;
+    }
+    for (; p < end; ++p) {
+        if ((*p & 0xC0) != 0x80 && --need == 0) return p;
+    }
+    return end;
+}
+
+// Decodifica il codepoint che inizia in p e avanza p oltre la sequenza.
+// Lancia Utf8Error se la sequenza non è UTF-8 valida.
+inline char32_t decodeUtf8Char(const unsigned char*& p, const unsigned char* end) {
+    uint32_t cp = 0;
+    unsigned char c = *p;
+
+    if (c < 0x80) {
+        cp = c;
+        ++p;
+    } else if ((c >> 5) == 0x6) { // 2 byte
+        if (p + 1 >= end) throw Utf8Error("Stringa UTF-8 troncata (attesi 2 byte).");
+        unsigned char c1 = *(p + 1);
+        if ((c1 & 0xC0) != 0x80)
+            throw Utf8Error("Byte di continuazione UTF-8 non valido (sequenza a 2 byte).");
+        cp = (c & 0x1F) << 6;
+        cp |= (c1 & 0x3F);
+        p += 2;
+    } else if ((c >> 4) == 0xE) { // 3 byte
+        if (p + 2 >= end) throw Utf8Error("Stringa UTF-8 troncata (attesi 3 byte).");
+        unsigned char c1 = *(p + 1);
+        unsigned char c2 = *(p + 2);
+        if ((c1 & 0xC0) != 0x80 || (c2 & 0xC0) != 0x80)
+            throw Utf8Error("Byte di continuazione UTF-8 non valido (sequenza a 3 byte).");
+        cp = (c & 0x0F) << 12;
+        cp |= (c1 & 0x3F) << 6;
+        cp |= (c2 & 0x3F);
+        p += 3;
+    } else if ((c >> 3) == 0x1E) { // 4 byte
+        if (p + 3 >= end) throw Utf8Error("Stringa UTF-8 troncata (attesi 4 byte).");
+        unsigned char c1 = *(p + 1);
+        unsigned char c2 = *(p + 2);
+        unsigned char c3 = *(p + 3);
+        if ((c1 & 0xC0) != 0x80 || (c2 & 0xC0) != 0x80 || (c3 & 0xC0) != 0x80)
+            throw Utf8Error("Byte di continuazione UTF-8 non valido (sequenza a 4 byte).");
+        cp = (c & 0x07) << 18;
+        cp |= (c1 & 0x3F) << 12;
+        cp |= (c2 & 0x3F) << 6;
+        cp |= (c3 & 0x3F);
+        p += 4;
+    } else {
+        throw Utf8Error("Byte iniziale UTF-8 non valido.");
+    }
+
+    // Escludiamo surrogate e valori fuori Unicode
+    if (cp >= 0xD800 && cp <= 0xDFFF)
+        throw Utf8Error("Codepoint UTF-8 surrogato non valido.");
+    if (cp > 0x10FFFF)
+        throw Utf8Error("Codepoint UTF-8 fuori range Unicode.");
+
+    return static_cast<char32_t>(cp);
+}
+
 // Decodifica stringa UTF-8 in codepoint (char32_t).
 // Lancia Utf8Error se la stringa non è UTF-8 valida.
 inline std::vector<char32_t> decodeUtf8(const std::string& s) {
@@ -18,54 +207,16 @@ inline std::vector<char32_t> decodeUtf8(const std::string& s) {
     const unsigned char* p   = reinterpret_cast<const unsigned char*>(s.data());
     const unsigned char* end = p + s.size();
 
+    out.reserve(s.size());
     while (p < end) {
-        uint32_t cp = 0;
-        unsigned char c = *p;
-
-        if (c < 0x80) {
-            cp = c;
-            ++p;
-        } else if ((c >> 5) == 0x6) { // 2 byte
-            if (p + 1 >= end) throw Utf8Error("Stringa UTF-8 troncata (attesi 2 byte).");
-            unsigned char c1 = *(p + 1);
-            if ((c1 & 0xC0) != 0x80)
-                throw Utf8Error("Byte di continuazione UTF-8 non valido (sequenza a 2 byte).");
-            cp = (c & 0x1F) << 6;
-            cp |= (c1 & 0x3F);
-            p += 2;
-        } else if ((c >> 4) == 0xE) { // 3 byte
-            if (p + 2 >= end) throw Utf8Error("Stringa UTF-8 troncata (attesi 3 byte).");
-            unsigned char c1 = *(p + 1);
-            unsigned char c2 = *(p + 2);
-            if ((c1 & 0xC0) != 0x80 || (c2 & 0xC0) != 0x80)
-                throw Utf8Error("Byte di continuazione UTF-8 non valido (sequenza a 3 byte).");
-            cp = (c & 0x0F) << 12;
-            cp |= (c1 & 0x3F) << 6;
-            cp |= (c2 & 0x3F);
-            p += 3;
-        } else if ((c >> 3) == 0x1E) { // 4 byte
-            if (p + 3 >= end) throw Utf8Error("Stringa UTF-8 troncata (attesi 4 byte).");
-            unsigned char c1 = *(p + 1);
-            unsigned char c2 = *(p + 2);
-            unsigned char c3 = *(p + 3);
-            if ((c1 & 0xC0) != 0x80 || (c2 & 0xC0) != 0x80 || (c3 & 0xC0) != 0x80)
-                throw Utf8Error("Byte di continuazione UTF-8 non valido (sequenza a 4 byte).");
-            cp = (c & 0x07) << 18;
-            cp |= (c1 & 0x3F) << 12;
-            cp |= (c2 & 0x3F) << 6;
-            cp |= (c3 & 0x3F);
-            p += 4;
-        } else {
-            throw Utf8Error("Byte iniziale UTF-8 non valido.");
+        // Sequenze ASCII: copiate senza decodifica
+        if (*p < 0x80) {
+            size_t run = utf8AsciiPrefix(p, static_cast<size_t>(end - p));
+            out.insert(out.end(), p, p + run);
+            p += run;
+            continue;
         }
-
-        // Escludiamo surrogate e valori fuori Unicode
-        if (cp >= 0xD800 && cp <= 0xDFFF)
-            throw Utf8Error("Codepoint UTF-8 surrogato non valido.");
-        if (cp > 0x10FFFF)
-            throw Utf8Error("Codepoint UTF-8 fuori range Unicode.");
-
-        out.push_back(static_cast<char32_t>(cp));
+        out.push_back(decodeUtf8Char(p, end));
     }
 
     return out;
@@ -98,30 +249,129 @@ inline std::string encodeUtf8(const std::vector<char32_t>& cps) {
     return out;
 }
 
+// ============================================================
+// Indice dei codepoint di una stringa
+// Costruito una volta per stringa (vedi Box<std::string>): len,
+// indicizzazione e slicing non decodificano più l'intera stringa.
+// Le stringhe ASCII non hanno offset (codepoint i = byte i); le
+// altre salvano il byte di inizio di un codepoint ogni STRIDE, e
+// un accesso decodifica al più STRIDE - 1 codepoint.
+// ============================================================
+struct Utf8Index {
+    static constexpr size_t STRIDE = 32;
+
+    bool valid = true;          // false: 'error' è il messaggio di Utf8Error
+    std::string error;
+    bool ascii = true;
+    bool shortest = true;       // ogni sequenza è nella forma più corta
+    size_t length = 0;          // numero di codepoint
+    std::vector<size_t> offsets;
+};
+
+inline size_t utf8EncodedLength(char32_t cp) {
+    return cp < 0x80 ? 1 : cp < 0x800 ? 2 : cp < 0x10000 ? 3 : 4;
+}
+
+inline Utf8Index buildUtf8Index(const std::string& s) {
+    Utf8Index idx;
+    const unsigned char* begin = reinterpret_cast<const unsigned char*>(s.data());
+    const unsigned char* end   = begin + s.size();
+
+    const unsigned char* p = begin;
+    size_t run = utf8AsciiPrefix(p, s.size());
+    if (run == s.size()) {
+        idx.length = s.size();
+        return idx;
+    }
+
+    idx.ascii = false;
+    try {
+        while (p < end) {
+            // Sequenza ASCII: un codepoint per byte
+            if (*p < 0x80) {
+                if (run == 0) run = utf8AsciiPrefix(p, static_cast<size_t>(end - p));
+                size_t first = (idx.length + Utf8Index::STRIDE - 1) / Utf8Index::STRIDE;
+                size_t last = (idx.length + run - 1) / Utf8Index::STRIDE;
+                for (size_t k = first; k <= last; ++k)
+                    idx.offsets.push_back(static_cast<size_t>(p - begin) + k * Utf8Index::STRIDE - idx.length);
+                idx.length += run;
+                p += run;
+                run = 0;
+                continue;
+            }
+            if (idx.length % Utf8Index::STRIDE == 0)
+                idx.offsets.push_back(static_cast<size_t>(p - begin));
+            const unsigned char* start = p;
+            char32_t cp = decodeUtf8Char(p, end);
+            if (utf8EncodedLength(cp) != static_cast<size_t>(p - start))
+                idx.shortest = false;
+            ++idx.length;
+        }
+    } catch (const Utf8Error& e) {
+        idx.valid = false;
+        idx.error = e.what();
+    }
+    return idx;
+}
+
+// Byte di inizio del codepoint i (i == length → fine stringa)
+inline size_t utf8ByteOffset(const std::string& s, const Utf8Index& idx, size_t i) {
+    if (idx.ascii) return i;
+    if (i >= idx.length) return s.size();
+
+    const unsigned char* begin = reinterpret_cast<const unsigned char*>(s.data());
+    const unsigned char* p = begin + idx.offsets[i / Utf8Index::STRIDE];
+    return static_cast<size_t>(utf8Advance(p, begin + s.size(), i % Utf8Index::STRIDE) - begin);
+}
+
+// Codepoint [start, start + count) di una stringa valida, come
+// encodeUtf8 dei codepoint decodificati
+inline std::string utf8Codepoints(const std::string& s, const Utf8Index& idx,
+                                  size_t start, size_t count) {
+    if (idx.ascii) return s.substr(start, count);
+
+    // Sequenze non minime: la ricodifica le accorcia
+    if (!idx.shortest) {
+        auto cps = decodeUtf8(s);
+        return encodeUtf8(std::vector<char32_t>(cps.begin() + start,
+                                                cps.begin() + start + count));
+    }
+
+    size_t from = utf8ByteOffset(s, idx, start);
+    size_t to = utf8ByteOffset(s, idx, start + count);
+    return s.substr(from, to - from);
+}
+
 // Concatenazione di due stringhe UTF-8
 inline std::string utf8Concat(const std::string& s1, const std::string& s2) {
     return s1 + s2;
 }
 
+// Indice di una stringa che deve essere valida (altrimenti Utf8Error)
+inline Utf8Index validUtf8Index(const std::string& s) {
+    Utf8Index idx = buildUtf8Index(s);
+    if (!idx.valid) throw Utf8Error(idx.error);
+    return idx;
+}
+
 // Estrae una sottostringa (substring) da una stringa UTF-8,
 // usando indici in unità di codepoint (non byte).
 // start è indice zero-based, length è numero di codepoint da estrarre.
 inline std::string utf8Substring(const std::string& s, size_t start, size_t length) {
-    auto cps = decodeUtf8(s);
+    Utf8Index idx = validUtf8Index(s);
 
-    if (start > cps.size()) start = cps.size();
-    if (start + length > cps.size()) length = cps.size() - start;
+    if (start > idx.length) start = idx.length;
+    if (start + length > idx.length) length = idx.length - start;
 
-    std::vector<char32_t> slice(cps.begin() + start, cps.begin() + start + length);
-    return encodeUtf8(slice);
+    return utf8Codepoints(s, idx, start, length);
 }
 
 // Slice simile a substring, ma permette anche indici negativi (per contare da fine)
 // start < 0 significa cps.size() + start
 // length < 0 significa fino alla fine della stringa
 inline std::string utf8Slice(const std::string& s, int start, int length = -1) {
-    auto cps = decodeUtf8(s);
-    int size = static_cast<int>(cps.size());
+    Utf8Index idx = validUtf8Index(s);
+    int size = static_cast<int>(idx.length);
 
     if (start < 0)
         start = size + start;
@@ -135,15 +385,14 @@ inline std::string utf8Slice(const std::string& s, int start, int length = -1) {
     if (length < 0)
         length = 0;
 
-    std::vector<char32_t> slice(cps.begin() + start, cps.begin() + start + length);
-    return encodeUtf8(slice);
+    return utf8Codepoints(s, idx, start, length);
 }
 
 // Slice di stringa UTF-8 usando range start:end (incluso/escluso).
 // Indici negativi contano dalla fine della stringa.
 inline std::string utf8SliceRange(const std::string& s, int start, int end) {
-    auto cps = decodeUtf8(s);
-    int size = static_cast<int>(cps.size());
+    Utf8Index idx = validUtf8Index(s);
+    int size = static_cast<int>(idx.length);
 
     // Normalizza indici negativi
     if (start < 0) start = size + start;
@@ -154,8 +403,7 @@ inline std::string utf8SliceRange(const std::string& s, int start, int end) {
     if (end > size) end = size;
     if (start > end) return ""; // slice vuota
 
-    std::vector<char32_t> slice(cps.begin() + start, cps.begin() + end);
-    return encodeUtf8(slice);
+    return utf8Codepoints(s, idx, start, end - start);
 }
 
 
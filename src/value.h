@@ -6,6 +6,13 @@
 #include <vector>
 #include <memory>
 #include <unordered_map>
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+#include "symbols.h"
+#include "utf8.h"
 
 // Forward
 struct ASTNode;
@@ -18,76 +25,433 @@ struct Value; // definito dopo
 
 // ------------------------------
 // Array Mammuth
+// Storage contiguo tipizzato: int, double e string hanno un vettore
+// dedicato; con tipi misti (o funzioni/array annidati) l'array passa
+// alla forma generica "boxed" (vettore di Value).
+// range() produce un IntRange non materializzato: letture, len,
+// slicing, for-in e filter non allocano; la prima scrittura lo
+// converte in vettore di int (materialize).
+// Gli elementi si leggono/scrivono solo tramite l'API (get/set/...).
 // ------------------------------
+struct IntRange {
+    int start = 0;
+    int step = 1;
+    size_t count = 0;
+
+    int at(size_t i) const {
+        return static_cast<int>(start + static_cast<long long>(step) * static_cast<long long>(i));
+    }
+};
+
 struct ArrayValue {
-    std::vector<std::shared_ptr<Value>> elements;
+    enum class Kind : uint8_t { Int, Double, String, Boxed, Range };
+
+    using Storage = std::variant<std::vector<int>,
+                                 std::vector<double>,
+                                 std::vector<std::string>,
+                                 std::vector<Value>,
+                                 IntRange>;
+    Storage data;
+
+    ArrayValue() = default;
+    explicit ArrayValue(std::vector<int> v) : data(std::move(v)) {}
+    explicit ArrayValue(std::vector<double> v) : data(std::move(v)) {}
+    explicit ArrayValue(std::vector<std::string> v) : data(std::move(v)) {}
+    explicit ArrayValue(IntRange r) : data(r) {}
 
-    bool empty() const { return elements.empty(); }
-    size_t size() const { return elements.size(); }
+    Kind kind() const { return static_cast<Kind>(data.index()); }
 
-    void push_back(const std::shared_ptr<Value>& v) { elements.push_back(v); }
+    bool empty() const { return size() == 0; }
+    inline size_t size() const;
 
-    const std::shared_ptr<Value>& operator[](size_t i) const { return elements[i]; }
-    std::shared_ptr<Value>& operator[](size_t i) { return elements[i]; }
+    inline Value get(size_t i) const;
+    inline Value back() const;
+    inline void set(size_t i, const Value& v);
+    inline void push_back(const Value& v);
+    inline void pop_back();
+    inline void append(const ArrayValue& other);
+    inline void reserve(size_t n);
+    void clear() { data = std::vector<int>{}; }
+
+    // Accesso diretto allo storage tipizzato (nullptr se di altro tipo)
+    const std::vector<int>* ints() const { return std::get_if<std::vector<int>>(&data); }
+    const std::vector<double>* doubles() const { return std::get_if<std::vector<double>>(&data); }
+    const std::vector<std::string>* strings() const { return std::get_if<std::vector<std::string>>(&data); }
+    const IntRange* range() const { return std::get_if<IntRange>(&data); }
+
+    // Range → vettore di int (prima di ogni scrittura)
+    inline void materialize();
+
+private:
+    static inline Kind kindOf(const Value& v);
+    inline bool accepts(const Value& v) const;
+    inline void toBoxed();
 };
 
 // ------------------------------
 // Funzione utente
 // ------------------------------
+struct CapturedEnv;
+
 struct FunctionValue {
-    std::vector<std::string> params;
+    std::vector<Symbol> params;
     std::shared_ptr<ASTNode> body;
     Scope* closureScope = nullptr;  // Deprecato, uso capturedVars
     
-    // Variabili catturate dalla closure (copia dei valori)
-    std::unordered_map<std::string, Value> capturedVars;
+    // Variabili catturate dalla closure: solo le variabili libere del body,
+    // in un ambiente immutabile condiviso tra le copie della funzione
+    std::shared_ptr<const CapturedEnv> capturedVars;
     
     // Per composizione: f $ g
     std::vector<std::shared_ptr<FunctionValue>> composedFuncs;
     std::unordered_map<std::string, std::string> extra;  // Metadati
 };
 
+// ------------------------------
+// Oggetti heap referenziati dai Value
+// Conteggio riferimenti intrusivo e atomico: lo stesso oggetto può
+// essere condiviso tra più Value (anche su thread diversi).
+// ------------------------------
+struct HeapBox {
+    std::atomic<uint32_t> refs{1};
+};
+
+template<typename T>
+struct Box : HeapBox {
+    T value;
+
+    template<typename... A>
+    explicit Box(A&&... args) : value(std::forward<A>(args)...) {}
+};
+
+// Stringa: con l'indice dei codepoint, costruito alla prima richiesta e
+// pubblicato atomicamente (più thread possono leggere la stessa stringa).
+// Ogni scrittura (as<std::string> non-const) lo scarta.
+template<>
+struct Box<std::string> : HeapBox {
+    std::string value;
+    mutable std::atomic<const Utf8Index*> index{nullptr};
+
+    template<typename... A>
+    explicit Box(A&&... args) : value(std::forward<A>(args)...) {}
+    ~Box() { delete index.load(std::memory_order_relaxed); }
+
+    const Utf8Index& utf8() const {
+        const Utf8Index* idx = index.load(std::memory_order_acquire);
+        if (idx) return *idx;
+        auto* fresh = new Utf8Index(buildUtf8Index(value));
+        if (index.compare_exchange_strong(idx, fresh, std::memory_order_acq_rel,
+                                          std::memory_order_acquire))
+            return *fresh;
+        delete fresh;   // un altro thread l'ha già pubblicato
+        return *idx;
+    }
+
+    void dropIndex() {
+        if (index.load(std::memory_order_relaxed))
+            delete index.exchange(nullptr, std::memory_order_acq_rel);
+    }
+};
+
 // ------------------------------
 // Wrapper Value vero e proprio
+// 16 byte: tag + int/double inline oppure puntatore a un Box
+// (string, array, funzione).
 // ------------------------------
 struct Value {
-    using Variant = std::variant<
-        int,
-        double,
-        std::string,
-        FunctionValue,
-        ArrayValue
-    >;
+    enum class Tag : uint8_t { Int, Double, String, Function, Array };
 
-    Variant data;
+    Tag tag;
+    union {
+        int i;
+        double d;
+        HeapBox* box;
+        uint64_t bits;  // copia grezza del payload
+    };
 
     // costruttori comodi
-    Value() : data(0) {}
-    Value(int v) : data(v) {}
-    Value(double v) : data(v) {}
-    Value(const std::string& v) : data(v) {}
-    Value(const char* s) : data(std::string(s)) {}
-    Value(const FunctionValue& f) : data(f) {}
-    Value(const ArrayValue& a) : data(a) {}
-    Value(const Variant& v) : data(v) {}
+    Value() : tag(Tag::Int), bits(0) {}
+    Value(int v) : tag(Tag::Int), bits(0) { i = v; }
+    Value(double v) : tag(Tag::Double), d(v) {}
+    inline Value(const std::string& v);
+    inline Value(std::string&& v);
+    inline Value(const char* s);
+    inline Value(const FunctionValue& f);
+    inline Value(FunctionValue&& f);
+    inline Value(const ArrayValue& a);
+    inline Value(ArrayValue&& a);
+
+    inline Value(const Value& other);
+    Value(Value&& other) noexcept : tag(other.tag), bits(other.bits) {
+        other.tag = Tag::Int;
+        other.bits = 0;
+    }
+    inline Value& operator=(const Value& other);
+    inline Value& operator=(Value&& other) noexcept;
+    ~Value() { release(); }
+
+    bool isHeap() const { return tag >= Tag::String; }
+
+    // Copy-on-write (vedi as<T>)
+    inline void unshare();
+
+private:
+    inline void release();
+    inline void copyFrom(const Value& other);
+};
+
+static_assert(sizeof(Value) == 16, "Value deve restare di 16 byte");
+
+// ------------------------------
+// Ambiente catturato da una closure
+// ------------------------------
+struct CapturedVar {
+    Symbol name;
+    int slot = -1;      // slot nel frame del body (-1 → define per nome)
+    Value value;
+};
+
+struct CapturedEnv {
+    std::vector<CapturedVar> vars;
 };
 
 // ------------------------------
 // Helper generici per Value
 // ------------------------------
+template<typename T>
+constexpr Value::Tag valueTagOf() {
+    if constexpr (std::is_same_v<T, int>)                return Value::Tag::Int;
+    else if constexpr (std::is_same_v<T, double>)        return Value::Tag::Double;
+    else if constexpr (std::is_same_v<T, std::string>)   return Value::Tag::String;
+    else if constexpr (std::is_same_v<T, FunctionValue>) return Value::Tag::Function;
+    else {
+        static_assert(std::is_same_v<T, ArrayValue>, "tipo non rappresentabile in Value");
+        return Value::Tag::Array;
+    }
+}
+
 template<typename T>
 inline bool isType(const Value& v) {
-    return std::holds_alternative<T>(v.data);
+    return v.tag == valueTagOf<T>();
 }
 
+// Precondizione: isType<T>(v)
+// L'accesso non-const a string/array è una scrittura: se il Box è
+// condiviso viene prima clonato (copy-on-write). Per sola lettura
+// usare un const Value&.
 template<typename T>
 inline T& as(Value& v) {
-    return std::get<T>(v.data);
+    if constexpr (std::is_same_v<T, int>)         return v.i;
+    else if constexpr (std::is_same_v<T, double>) return v.d;
+    else {
+        if constexpr (!std::is_same_v<T, FunctionValue>) v.unshare();
+        if constexpr (std::is_same_v<T, std::string>) static_cast<Box<T>*>(v.box)->dropIndex();
+        return static_cast<Box<T>*>(v.box)->value;
+    }
 }
 
 template<typename T>
 inline const T& as(const Value& v) {
-    return std::get<T>(v.data);
+    if constexpr (std::is_same_v<T, int>)         return v.i;
+    else if constexpr (std::is_same_v<T, double>) return v.d;
+    else return static_cast<const Box<T>*>(v.box)->value;
+}
+
+// Indice dei codepoint di una stringa (precondizione: isType<std::string>)
+inline const Utf8Index& utf8IndexOf(const Value& v) {
+    return static_cast<const Box<std::string>*>(v.box)->utf8();
+}
+
+// ------------------------------
+// Value: costruzione, copia e rilascio dei Box
+// La copia condivide sempre il Box (O(1)); string e array sono
+// clonati solo alla prima scrittura su un Box condiviso.
+// ------------------------------
+inline Value::Value(const std::string& v) : tag(Tag::String), box(new Box<std::string>(v)) {}
+inline Value::Value(std::string&& v) : tag(Tag::String), box(new Box<std::string>(std::move(v))) {}
+inline Value::Value(const char* s) : tag(Tag::String), box(new Box<std::string>(s)) {}
+inline Value::Value(const FunctionValue& f) : tag(Tag::Function), box(new Box<FunctionValue>(f)) {}
+inline Value::Value(FunctionValue&& f) : tag(Tag::Function), box(new Box<FunctionValue>(std::move(f))) {}
+inline Value::Value(const ArrayValue& a) : tag(Tag::Array), box(new Box<ArrayValue>(a)) {}
+inline Value::Value(ArrayValue&& a) : tag(Tag::Array), box(new Box<ArrayValue>(std::move(a))) {}
+
+inline Value::Value(const Value& other) : tag(Tag::Int), bits(0) {
+    copyFrom(other);
+}
+
+inline Value& Value::operator=(const Value& other) {
+    if (this == &other) return *this;
+    Value tmp(other);
+    *this = std::move(tmp);
+    return *this;
+}
+
+inline Value& Value::operator=(Value&& other) noexcept {
+    if (this == &other) return *this;
+    release();
+    tag = other.tag;
+    bits = other.bits;
+    other.tag = Tag::Int;
+    other.bits = 0;
+    return *this;
+}
+
+inline void Value::copyFrom(const Value& other) {
+    bits = other.bits;
+    tag = other.tag;
+    if (isHeap()) box->refs.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Copy-on-write: rende esclusivo il Box di una string/array prima di modificarlo
+inline void Value::unshare() {
+    if (!isHeap() || box->refs.load(std::memory_order_acquire) == 1) return;
+
+    HeapBox* fresh = nullptr;
+    switch (tag) {
+        case Tag::String: fresh = new Box<std::string>(as<std::string>(std::as_const(*this))); break;
+        case Tag::Array:  fresh = new Box<ArrayValue>(as<ArrayValue>(std::as_const(*this))); break;
+        default: return;
+    }
+    Tag t = tag;
+    release();
+    tag = t;
+    box = fresh;
+}
+
+inline void Value::release() {
+    if (!isHeap()) return;
+    if (box->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        switch (tag) {
+            case Tag::String:   delete static_cast<Box<std::string>*>(box); break;
+            case Tag::Function: delete static_cast<Box<FunctionValue>*>(box); break;
+            case Tag::Array:    delete static_cast<Box<ArrayValue>*>(box); break;
+            default: break;
+        }
+    }
+    tag = Tag::Int;
+    bits = 0;
+}
+
+// ------------------------------
+// ArrayValue: implementazione (richiede Value completo)
+// ------------------------------
+inline size_t ArrayValue::size() const {
+    switch (kind()) {
+        case Kind::Int:    return std::get<0>(data).size();
+        case Kind::Double: return std::get<1>(data).size();
+        case Kind::String: return std::get<2>(data).size();
+        case Kind::Range:  return std::get<4>(data).count;
+        default:           return std::get<3>(data).size();
+    }
+}
+
+inline Value ArrayValue::get(size_t i) const {
+    switch (kind()) {
+        case Kind::Int:    return std::get<0>(data)[i];
+        case Kind::Double: return std::get<1>(data)[i];
+        case Kind::String: return std::get<2>(data)[i];
+        case Kind::Range:  return std::get<4>(data).at(i);
+        default:           return std::get<3>(data)[i];
+    }
+}
+
+inline Value ArrayValue::back() const {
+    return get(size() - 1);
+}
+
+inline ArrayValue::Kind ArrayValue::kindOf(const Value& v) {
+    if (isType<int>(v))         return Kind::Int;
+    if (isType<double>(v))      return Kind::Double;
+    if (isType<std::string>(v)) return Kind::String;
+    return Kind::Boxed;
+}
+
+inline bool ArrayValue::accepts(const Value& v) const {
+    Kind k = kind();
+    return k == Kind::Boxed || k == kindOf(v);
+}
+
+inline void ArrayValue::materialize() {
+    const IntRange* r = range();
+    if (!r) return;
+    std::vector<int> ints(r->count);
+    for (size_t i = 0; i < r->count; ++i) ints[i] = r->at(i);
+    data = std::move(ints);
+}
+
+// Tipi misti: converte lo storage tipizzato in vettore di Value
+inline void ArrayValue::toBoxed() {
+    if (kind() == Kind::Boxed) return;
+    std::vector<Value> boxed;
+    boxed.reserve(size());
+    for (size_t i = 0; i < size(); ++i) boxed.push_back(get(i));
+    data = std::move(boxed);
+}
+
+inline void ArrayValue::set(size_t i, const Value& v) {
+    materialize();
+    if (!accepts(v)) toBoxed();
+    switch (kind()) {
+        case Kind::Int:    std::get<0>(data)[i] = as<int>(v); break;
+        case Kind::Double: std::get<1>(data)[i] = as<double>(v); break;
+        case Kind::String: std::get<2>(data)[i] = as<std::string>(v); break;
+        default:           std::get<3>(data)[i] = v; break;
+    }
+}
+
+inline void ArrayValue::push_back(const Value& v) {
+    materialize();
+    // Array vuoto: lo storage segue il tipo del primo elemento
+    if (empty() && !accepts(v)) {
+        switch (kindOf(v)) {
+            case Kind::Int:    data = std::vector<int>{}; break;
+            case Kind::Double: data = std::vector<double>{}; break;
+            case Kind::String: data = std::vector<std::string>{}; break;
+            default:           data = std::vector<Value>{}; break;
+        }
+    }
+    if (!accepts(v)) toBoxed();
+    switch (kind()) {
+        case Kind::Int:    std::get<0>(data).push_back(as<int>(v)); break;
+        case Kind::Double: std::get<1>(data).push_back(as<double>(v)); break;
+        case Kind::String: std::get<2>(data).push_back(as<std::string>(v)); break;
+        default:           std::get<3>(data).push_back(v); break;
+    }
+}
+
+inline void ArrayValue::pop_back() {
+    materialize();
+    std::visit([](auto& vec) {
+        if constexpr (!std::is_same_v<std::decay_t<decltype(vec)>, IntRange>) vec.pop_back();
+    }, data);
+}
+
+inline void ArrayValue::reserve(size_t n) {
+    materialize();
+    std::visit([n](auto& vec) {
+        if constexpr (!std::is_same_v<std::decay_t<decltype(vec)>, IntRange>) vec.reserve(n);
+    }, data);
+}
+
+inline void ArrayValue::append(const ArrayValue& other) {
+    if (other.empty()) return;
+    if (empty()) {
+        data = other.data;
+        return;
+    }
+    materialize();
+    // Stesso tipo: copia contigua
+    if (kind() == other.kind()) {
+        std::visit([&](auto& vec) {
+            using Vec = std::decay_t<decltype(vec)>;
+            if constexpr (!std::is_same_v<Vec, IntRange>) {
+                const auto& src = std::get<Vec>(other.data);
+                vec.insert(vec.end(), src.begin(), src.end());
+            }
+        }, data);
+        return;
+    }
+    for (size_t i = 0; i < other.size(); ++i) push_back(other.get(i));
 }
 
 #endif
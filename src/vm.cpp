@@ -0,0 +1,421 @@
+#include "vm.h"
+#include "compiler.h"
+#include "interpreter.h"
+#include "debug.h"
+
+#include <iostream>
+#include <memory>
+#include <new>
+
+VM::VM(Interpreter& interp) : interp(interp) {
+    interp.vm = this;
+}
+
+VM::~VM() {
+    if (interp.vm == this) interp.vm = nullptr;
+}
+
+const Chunk& VM::chunkFor(const std::shared_ptr<ASTNode>& node) {
+    auto it = chunks.find(node.get());
+    if (it != chunks.end()) return *it->second;
+
+    BytecodeCompiler compiler;
+    auto& slot = chunks[node.get()];
+    slot = compiler.compile(node);
+    return *slot;
+}
+
+Value VM::run(const std::shared_ptr<ASTNode>& node) {
+    if (!node) return 0;
+    if (node->kind == NodeKind::Program) interp.enterProgram(*node);
+    return execute(chunkFor(node));
+}
+
+// ============================================================
+// Stack degli operandi di un execute(): spazio grezzo dimensionato da
+// Chunk::maxStack (in linea per i chunk piccoli), i Value sono
+// costruiti al push e distrutti al pop
+// ============================================================
+namespace {
+
+class OperandStack {
+public:
+    explicit OperandStack(int capacity) {
+        Slot* slots = inlineSlots;
+        if (capacity > INLINE_SLOTS) {
+            heap = std::make_unique<Slot[]>(capacity);
+            slots = heap.get();
+        }
+        base = sp = reinterpret_cast<Value*>(slots);
+    }
+    ~OperandStack() {
+        while (sp != base) pop();
+    }
+    OperandStack(const OperandStack&) = delete;
+    OperandStack& operator=(const OperandStack&) = delete;
+
+    void push(const Value& v) { new (sp++) Value(v); }
+    void push(Value&& v) { new (sp++) Value(std::move(v)); }
+    void pop() { (--sp)->~Value(); }
+    Value take() {
+        Value v = std::move(sp[-1]);
+        pop();
+        return v;
+    }
+    Value& top() { return sp[-1]; }
+    Value& below() { return sp[-2]; }
+    Value* end() { return sp; }
+    bool empty() const { return sp == base; }
+
+private:
+    static constexpr int INLINE_SLOTS = 32;
+    struct alignas(Value) Slot { unsigned char bytes[sizeof(Value)]; };
+
+    Slot inlineSlots[INLINE_SLOTS];
+    std::unique_ptr<Slot[]> heap;
+    Value* base;
+    Value* sp;
+};
+
+bool isNumber(const Value& v) {
+    return v.tag == Value::Tag::Int || v.tag == Value::Tag::Double;
+}
+
+double numberOf(const Value& v) {
+    return v.tag == Value::Tag::Int ? static_cast<double>(v.i) : v.d;
+}
+
+// Fast path degli operatori numerici, con gli stessi risultati di
+// Interpreter::evalBinaryOp: int op int resta int (confronti → 1/0),
+// int e double misti passano a double. false = caso lasciato
+// all'Interpreter (divisione per zero, == tra double, stringhe, ...)
+template<OpCode OP>
+bool arith(Value& left, const Value& right) {
+    if (left.tag == Value::Tag::Int && right.tag == Value::Tag::Int) {
+        int L = left.i;
+        int R = right.i;
+        if constexpr (OP == OpCode::ADD) left = Value(L + R);
+        else if constexpr (OP == OpCode::SUB) left = Value(L - R);
+        else if constexpr (OP == OpCode::MUL) left = Value(L * R);
+        else if constexpr (OP == OpCode::DIV) { if (R == 0) return false; left = Value(L / R); }
+        else if constexpr (OP == OpCode::MOD) { if (R == 0) return false; left = Value(L % R); }
+        else if constexpr (OP == OpCode::LT) left = Value(L < R ? 1 : 0);
+        else if constexpr (OP == OpCode::LE) left = Value(L <= R ? 1 : 0);
+        else if constexpr (OP == OpCode::GT) left = Value(L > R ? 1 : 0);
+        else if constexpr (OP == OpCode::GE) left = Value(L >= R ? 1 : 0);
+        else if constexpr (OP == OpCode::EQ) left = Value(L == R ? 1 : 0);
+        else if constexpr (OP == OpCode::NE) left = Value(L != R ? 1 : 0);
+        return true;
+    }
+
+    // == e != tra double confrontano la forma testuale: all'Interpreter
+    if constexpr (OP == OpCode::MOD || OP == OpCode::EQ || OP == OpCode::NE) {
+        return false;
+    } else {
+        if (!isNumber(left) || !isNumber(right)) return false;
+        double L = numberOf(left);
+        double R = numberOf(right);
+        if constexpr (OP == OpCode::ADD) left = Value(L + R);
+        else if constexpr (OP == OpCode::SUB) left = Value(L - R);
+        else if constexpr (OP == OpCode::MUL) left = Value(L * R);
+        else if constexpr (OP == OpCode::DIV) { if (R == 0.0) return false; left = Value(L / R); }
+        else if constexpr (OP == OpCode::LT) left = Value(L < R ? 1 : 0);
+        else if constexpr (OP == OpCode::LE) left = Value(L <= R ? 1 : 0);
+        else if constexpr (OP == OpCode::GT) left = Value(L > R ? 1 : 0);
+        else if constexpr (OP == OpCode::GE) left = Value(L >= R ? 1 : 0);
+        return true;
+    }
+}
+
+// Confronto int/int di un salto fuso: 1 vero, 0 falso, -1 caso generico
+template<OpCode OP>
+int intCompare(const Value& left, const Value& right) {
+    if (left.tag != Value::Tag::Int || right.tag != Value::Tag::Int) return -1;
+    int L = left.i;
+    int R = right.i;
+    if constexpr (OP == OpCode::LT) return L < R;
+    else if constexpr (OP == OpCode::LE) return L <= R;
+    else if constexpr (OP == OpCode::GT) return L > R;
+    else if constexpr (OP == OpCode::GE) return L >= R;
+    else if constexpr (OP == OpCode::EQ) return L == R;
+    else return L != R;
+}
+
+} // namespace
+
+// Slot c del frame a profondità b dallo scope corrente (nullptr se non definito)
+StoredVar* VM::slotVar(const Instruction& in) {
+    Scope* s = interp.scopes.back();
+    for (int d = in.b; d > 0 && s; --d) s = s->parent;
+    return s ? s->slotAt(in.c) : nullptr;
+}
+
+// ============================================================
+// Dispatch loop
+// ============================================================
+Value VM::execute(const Chunk& chunk) {
+    // Stack locali: execute() è rientrante (EVAL → chiamata → run)
+    OperandStack stack(chunk.maxStack);
+
+    // Iteratore for-in: snapshot della collezione (copia del Value, O(1))
+    struct Iter {
+        Value collection;
+        size_t index = 0;
+        size_t count = 0;
+    };
+    std::vector<Iter> iters;
+
+    // Call preparate (CALL_PREPARE) in attesa dei loro argomenti
+    std::vector<Interpreter::PreparedCall> calls;
+
+    // Operatore lasciato all'Interpreter: left resta sullo stack,
+    // letto per riferimento e poi sovrascritto
+    auto binary = [&](const Instruction& in) {
+        const ASTNode* node = chunk.nodes[in.a].get();
+        Value right = stack.take();
+        stack.top() = interp.evalBinaryOp(node->op, stack.top(), right, node);
+    };
+
+    // Operatore con fast path: done = risultato già in left
+    auto arithmetic = [&](bool done, const Instruction& in) {
+        if (done) stack.pop();
+        else binary(in);
+    };
+
+    size_t ip = 0;
+
+    // Confronto + salto: fast = esito del confronto int/int (-1 se non calcolato)
+    auto jumpUnless = [&](int fast, const Instruction& in) {
+        if (fast < 0) {
+            binary(in);
+            const Value& v = stack.top();
+            fast = (v.tag == Value::Tag::Int ? v.i != 0 : interp.isTruthy(v)) ? 1 : 0;
+        } else {
+            stack.pop();
+        }
+        stack.pop();
+        if (!fast) ip = in.b;
+    };
+
+    const Instruction* code = chunk.code.data();
+
+    while (true) {
+        const Instruction& in = code[ip++];
+
+        switch (in.op) {
+            case OpCode::CONST:
+                stack.push(chunk.constants[in.a]);
+                break;
+
+            case OpCode::LOAD:
+                stack.push(interp.lookup(chunk.names[in.a]));
+                break;
+
+            case OpCode::LOAD_VAR:
+                stack.push(interp.lookupVar(*chunk.nodes[in.a]));
+                break;
+
+            case OpCode::LOAD_SLOT:
+                if (StoredVar* sv = slotVar(in))
+                    stack.push(sv->value);
+                else
+                    stack.push(interp.lookupVar(*chunk.nodes[in.a]));
+                break;
+
+            case OpCode::DEFINE:
+                interp.defineVarAt(*chunk.nodes[in.a], stack.top(),
+                                   (in.b & DEFINE_DYNAMIC) != 0,
+                                   (in.b & DEFINE_FIXED) != 0);
+                stack.pop();
+                break;
+
+            case OpCode::STORE:
+                interp.setVarAt(*chunk.nodes[in.a], stack.top());
+                break;
+
+            case OpCode::STORE_SLOT:
+            case OpCode::STORE_SLOT_POP: {
+                // Senza fixed né array (vecchio o nuovo valore) l'assegnamento
+                // non ha controlli: il resto passa da setVarAt
+                StoredVar* sv = slotVar(in);
+                const Value& v = stack.top();
+                if (sv && !sv->isFixed && sv->value.tag != Value::Tag::Array &&
+                    v.tag != Value::Tag::Array)
+                    sv->value = v;
+                else
+                    interp.setVarAt(*chunk.nodes[in.a], v);
+                if (in.op == OpCode::STORE_SLOT_POP) stack.pop();
+                break;
+            }
+
+            case OpCode::POP:
+                stack.pop();
+                break;
+
+            case OpCode::BINARY:
+                binary(in);
+                break;
+
+            case OpCode::ADD:
+                arithmetic(arith<OpCode::ADD>(stack.below(), stack.top()), in);
+                break;
+            case OpCode::SUB:
+                arithmetic(arith<OpCode::SUB>(stack.below(), stack.top()), in);
+                break;
+            case OpCode::MUL:
+                arithmetic(arith<OpCode::MUL>(stack.below(), stack.top()), in);
+                break;
+            case OpCode::DIV:
+                arithmetic(arith<OpCode::DIV>(stack.below(), stack.top()), in);
+                break;
+            case OpCode::MOD:
+                arithmetic(arith<OpCode::MOD>(stack.below(), stack.top()), in);
+                break;
+            case OpCode::LT:
+                arithmetic(arith<OpCode::LT>(stack.below(), stack.top()), in);
+                break;
+            case OpCode::LE:
+                arithmetic(arith<OpCode::LE>(stack.below(), stack.top()), in);
+                break;
+            case OpCode::GT:
+                arithmetic(arith<OpCode::GT>(stack.below(), stack.top()), in);
+                break;
+            case OpCode::GE:
+                arithmetic(arith<OpCode::GE>(stack.below(), stack.top()), in);
+                break;
+            case OpCode::EQ:
+                arithmetic(arith<OpCode::EQ>(stack.below(), stack.top()), in);
+                break;
+            case OpCode::NE:
+                arithmetic(arith<OpCode::NE>(stack.below(), stack.top()), in);
+                break;
+
+            case OpCode::UNARY: {
+                const ASTNode* node = chunk.nodes[in.a].get();
+                stack.top() = interp.evalUnaryOp(node->op, stack.top(), node);
+                break;
+            }
+
+            case OpCode::JUMP:
+                ip = in.a;
+                break;
+
+            case OpCode::JUMP_IF_FALSE: {
+                const Value& v = stack.top();
+                bool cond = v.tag == Value::Tag::Int ? v.i != 0 : interp.isTruthy(v);
+                stack.pop();
+                if (!cond) ip = in.a;
+                break;
+            }
+            case OpCode::JUMP_UNLESS_LT:
+                jumpUnless(intCompare<OpCode::LT>(stack.below(), stack.top()), in);
+                break;
+            case OpCode::JUMP_UNLESS_LE:
+                jumpUnless(intCompare<OpCode::LE>(stack.below(), stack.top()), in);
+                break;
+            case OpCode::JUMP_UNLESS_GT:
+                jumpUnless(intCompare<OpCode::GT>(stack.below(), stack.top()), in);
+                break;
+            case OpCode::JUMP_UNLESS_GE:
+                jumpUnless(intCompare<OpCode::GE>(stack.below(), stack.top()), in);
+                break;
+            case OpCode::JUMP_UNLESS_EQ:
+                jumpUnless(intCompare<OpCode::EQ>(stack.below(), stack.top()), in);
+                break;
+            case OpCode::JUMP_UNLESS_NE:
+                jumpUnless(intCompare<OpCode::NE>(stack.below(), stack.top()), in);
+                break;
+
+            case OpCode::PRINT:
+                interp.printValue(stack.top());
+                std::cout << "\n";
+                break;
+
+            case OpCode::EVAL:
+                stack.push(interp.eval(chunk.nodes[in.a]));
+                break;
+
+            case OpCode::EXEC:
+                if (in.b) {
+                    Value discarded;
+                    interp.execStatement(chunk.nodes[in.a], discarded);
+                } else {
+                    interp.execStatement(chunk.nodes[in.a], stack.top());
+                }
+                break;
+
+            case OpCode::CALL_PREPARE: {
+                Interpreter::PreparedCall call = interp.prepareCall(*chunk.nodes[in.a]);
+                if (call.kind == Interpreter::PreparedCall::Kind::Done) {
+                    stack.push(std::move(call.value));
+                    ip = in.b;
+                    break;
+                }
+                calls.push_back(std::move(call));
+                break;
+            }
+
+            case OpCode::CALL: {
+                std::vector<Value> args;
+                args.reserve(in.b);
+                Value* first = stack.end() - in.b;
+                for (int i = 0; i < in.b; ++i) args.push_back(std::move(first[i]));
+                for (int i = 0; i < in.b; ++i) stack.pop();
+
+                Interpreter::PreparedCall call = std::move(calls.back());
+                calls.pop_back();
+                stack.push(interp.finishCall(call, std::move(args), *chunk.nodes[in.a]));
+                break;
+            }
+
+            case OpCode::LOAD_ARRAY: {
+                // Snapshot dell'array: l'indice è valutato dopo
+                const ASTNode& node = *chunk.nodes[in.a];
+                if (StoredVar* sv = interp.findVar(node)) {
+                    stack.push(sv->value);
+                    break;
+                }
+                interp.runtimeError(&node, "Variabile '" + node.value + "' non definita");
+                stack.push(Value(0));
+                ip = in.b;
+                break;
+            }
+
+            case OpCode::INDEX: {
+                Value idx = stack.take();
+                stack.top() = interp.indexValue(stack.top(), idx, chunk.nodes[in.a].get());
+                break;
+            }
+
+            case OpCode::ITER_START: {
+                Iter it;
+                it.collection = stack.take();
+
+                const Value& collection = it.collection;
+                if (!isType<ArrayValue>(collection)) {
+                    interp.runtimeError(chunk.nodes[in.b].get(), "for-in richiede un array");
+                    ip = in.a;
+                    break;
+                }
+                it.count = as<ArrayValue>(collection).size();
+                iters.push_back(std::move(it));
+                break;
+            }
+
+            case OpCode::ITER_NEXT: {
+                Iter& it = iters.back();
+                if (it.index >= it.count) {
+                    iters.pop_back();
+                    ip = in.a;
+                    break;
+                }
+                Value elem = as<ArrayValue>(std::as_const(it.collection)).get(it.index++);
+                interp.defineVarAt(*chunk.nodes[in.b], elem, false, false);
+                break;
+            }
+
+            case OpCode::RETURN:
+                return stack.empty() ? Value(0) : stack.take();
+        }
+    }
+}
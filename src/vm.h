@@ -0,0 +1,39 @@
+#ifndef MAMMUTH_VM_H
+#define MAMMUTH_VM_H
+
+#include <memory>
+#include <unordered_map>
+
+#include "ast.h"
+#include "value.h"
+#include "bytecode.h"
+#include "scope.h"
+
+class Interpreter;
+
+// ============================================================
+// VM a stack per il bytecode Mammuth (--engine=vm)
+// Condivide scope, funzioni e semantica con l'Interpreter:
+// finché il VM è attivo anche i body delle funzioni utente
+// vengono compilati ed eseguiti qui.
+// ============================================================
+class VM {
+public:
+    explicit VM(Interpreter& interp);
+    ~VM();
+
+    // Compila (una sola volta per nodo) ed esegue un Program o un Body
+    Value run(const std::shared_ptr<ASTNode>& node);
+
+private:
+    Interpreter& interp;
+
+    // Cache dei chunk compilati, per nodo
+    std::unordered_map<const ASTNode*, std::unique_ptr<Chunk>> chunks;
+
+    const Chunk& chunkFor(const std::shared_ptr<ASTNode>& node);
+    Value execute(const Chunk& chunk);
+    StoredVar* slotVar(const Instruction& in);
+};
+
+#endif // MAMMUTH_VM_H